@@ -0,0 +1,246 @@
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <utility>
+#include "analysis.h"
+#include "board.h"
+#include "notation.h"
+#include "pgn.h"
+#include "replay.h"
+#include "search.h"
+#include "transposition.h"
+
+static bool endsWith(const std::string &s, const std::string &suffix) {
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool isNumber(const std::string &s) {
+    return !s.empty() && s.find_first_not_of("0123456789") == std::string::npos;
+}
+
+// applies the operation op (e.g. "depth 6") of a position to job
+static void parseOperation(const std::string &op, AnalysisJob &job) {
+    std::istringstream words(op);
+    std::string name, value;
+    words >> name >> std::ws;
+    std::getline(words, value);
+    value.erase(value.find_last_not_of(" \t\r") + 1);
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+        value = value.substr(1, value.size() - 2);
+    }
+    if (name == "id" && !value.empty()) {
+        job.id = value;
+    } else if (name == "depth" && std::atoi(value.c_str()) > 0) {
+        job.limits.depth = std::atoi(value.c_str());
+    } else if (name == "nodes") {
+        job.limits.nodes = std::atol(value.c_str());
+    }
+}
+
+// parses line number of a list of positions into job
+static void parseLine(const std::string &line, size_t number, const AnalysisLimits &defaults,
+                      AnalysisJob &job) {
+    job.id = std::to_string(number);
+    job.limits = defaults;
+    std::istringstream fields(line);
+    std::string field;
+    std::getline(fields, field, ';');
+    std::istringstream words(field);
+    std::string word;
+    if (field.find('/') != std::string::npos) {
+        // a FEN: the 4 fields of the position, then the counters if any, then
+        // the first operation of an EPD line
+        for (int i = 0; i < 6 && words >> word; i++) {
+            if (i >= 4 && !isNumber(word)) {
+                break;
+            }
+            job.fen += (i > 0 ? " " : "") + word;
+            word.clear();
+        }
+        std::string op = word;
+        while (words >> word) {
+            op += " " + word;
+        }
+        parseOperation(op, job);
+    } else {
+        while (words >> word) {
+            job.moves.push_back(word);
+        }
+    }
+    while (std::getline(fields, field, ';')) {
+        parseOperation(field, job);
+    }
+}
+
+bool readAnalysisFile(const std::string &filename, const AnalysisLimits &defaults,
+                      std::vector<AnalysisJob> &jobs) {
+    if (endsWith(filename, ".pgn")) {
+        std::vector<PgnGame> games;
+        if (!readPgnFile(filename, games)) {
+            return false;
+        }
+        for (size_t i = 0; i < games.size(); i++) {
+            AnalysisJob job;
+            job.id = std::to_string(i + 1);
+            job.fen = games[i].tag("FEN");
+            job.moves = std::move(games[i].moves);
+            job.limits = defaults;
+            job.every_position = true;
+            jobs.push_back(std::move(job));
+        }
+        return true;
+    }
+    std::ifstream in(filename);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    size_t number = 0;
+    while (std::getline(in, line)) {
+        number++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        AnalysisJob job;
+        parseLine(line, number, defaults, job);
+        jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+// writes the result r of the search of b, identified by id, on out
+static void writeResult(const std::string &id, Board &b, const SearchResult &r,
+                        std::ostream &out) {
+    out << id << " bestmove ";
+    if (r.best == NULL) {
+        out << "none";
+    } else {
+        out << toSAN(b, r.best, r.best->isPromotion() ? 'Q' : ' ');
+    }
+    out << " score ";
+    if (std::abs(r.score) > MATE - 1000) {
+        // a mate in n plies, counted in moves of the player to move
+        int moves = (MATE - std::abs(r.score) + 1) / 2;
+        out << "mate " << (r.score > 0 ? moves : -moves);
+    } else {
+        out << r.score;
+    }
+    out << " depth " << r.depth << " nodes " << r.nodes << " pv";
+    // the SAN of each move depends on the position it is played from. The PV
+    // stops at the first promotion: the moves after it refer to the piece
+    // created by the search, deleted since.
+    size_t played = 0;
+    while (played < r.pv.size()) {
+        Move *m = r.pv[played];
+        out << " " << toSAN(b, m, m->isPromotion() ? 'Q' : ' ');
+        if (m->isPromotion()) {
+            break;
+        }
+        m->perform(&b);
+        b.switch_player();
+        played++;
+    }
+    while (played > 0) {
+        played--;
+        b.switch_player();
+        r.pv[played]->unPerform(&b);
+    }
+    out << "\n";
+}
+
+// the state a worker keeps from one position to the next
+struct AnalysisWorker {
+    Board board;
+    Search search;
+    std::unique_ptr<TranspositionTable> tt;
+};
+
+// the results of the jobs, written in the order of the jobs
+class OrderedOutput {
+public:
+    OrderedOutput(std::ostream &out, size_t n) : out_(out), results_(n), done_(n, false) { }
+
+    // stores the result of job i, and writes the results that can be
+    void put(size_t i, std::string result) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        results_[i] = std::move(result);
+        done_[i] = true;
+        bool written = false;
+        while (next_ < done_.size() && done_[next_]) {
+            out_ << results_[next_];
+            std::string().swap(results_[next_]);
+            next_++;
+            written = true;
+        }
+        if (written) {
+            out_.flush();
+        }
+    }
+
+private:
+    std::ostream &out_;
+    std::mutex mutex_;
+    std::vector<std::string> results_;
+    std::vector<bool> done_;
+    // the first job not written
+    size_t next_ = 0;
+};
+
+AnalysisSummary analyzePositions(const std::vector<AnalysisJob> &jobs, ThreadPool &pool,
+                                 size_t tt_mb, std::ostream &out) {
+    std::vector<AnalysisWorker> workers(pool.size());
+    for (auto &w : workers) {
+        w.tt.reset(new TranspositionTable(tt_mb));
+        w.search.setTable(w.tt.get());
+    }
+    OrderedOutput output(out, jobs.size());
+    std::atomic<long> positions(0);
+    std::atomic<long> errors(0);
+    std::atomic<long> nodes(0);
+    parallelFor(pool, jobs.size(), [&](size_t i, int worker) {
+        AnalysisWorker &w = workers[worker];
+        const AnalysisJob &job = jobs[i];
+        std::ostringstream text;
+        int ply = 0;
+        auto id = [&job, &ply]() {
+            return job.every_position ? job.id + "." + std::to_string(ply) : job.id;
+        };
+        auto analyze = [&](Board &b) {
+            SearchResult r = w.search.run(b, job.limits.depth, job.limits.nodes);
+            writeResult(id(), b, r, text);
+            deletePV(r, NULL);
+            nodes += r.nodes;
+            positions++;
+        };
+        MoveVisitor visit;
+        if (job.every_position) {
+            visit = [&](Board &b, Move *, char) {
+                analyze(b);
+                ply++;
+            };
+        }
+        PgnGame g;
+        if (!job.fen.empty()) {
+            g.tags.push_back(std::make_pair(std::string("FEN"), job.fen));
+        }
+        g.moves = job.moves;
+        ReplayResult res;
+        if (replayGame(w.board, g, res, visit)) {
+            analyze(w.board);
+        } else {
+            text << id() << " error " << res.error << "\n";
+            errors++;
+        }
+        output.put(i, text.str());
+    });
+    AnalysisSummary s;
+    s.positions = positions;
+    s.errors = errors;
+    s.nodes = nodes;
+    return s;
+}
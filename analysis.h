@@ -0,0 +1,86 @@
+// This module analyses many positions in batch, e.g. overnight: each position
+// is searched to its own limits (see search.h), and the best move, score,
+// depth and principal variation are written as soon as they are known.
+//
+// The positions are shared among the workers of a thread pool. Each worker
+// keeps its Board, its Search and its transposition table from one position
+// to the next, so the positions of a same game, analysed in a row by the same
+// worker, benefit from the previous searches.
+//
+// The positions are read from a file, either:
+// . a PGN file (its name ends with ".pgn"): every position of each game,
+//   from the initial one (or the one of its FEN tag) to the last, is
+//   analysed, with the default limits.
+//   They are identified as "game.ply", e.g. "12.0" for the initial position
+//   of the twelfth game.
+// . a list of positions, one per line, given by the moves (in SAN) played
+//   from the initial position, and optionally followed by operations
+//   separated by ';' that set the identifier and the limits of the position:
+//     e4 e5 Nf3 Nc6 Bb5; id ruy-lopez; depth 6; nodes 500000
+//   or by a FEN (see Board::fromFEN()), the counters being optional, which
+//   lets EPD lines be read as they are (the operations other than id, depth
+//   and nodes are ignored, the quotes of a value are removed):
+//     r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - id "ruy-lopez";
+//   Empty lines and lines starting with '#' are skipped. Positions without
+//   id are identified by their line number.
+//
+// For each position one line is written, in the order of the file:
+//   <id> bestmove <san> score <score> depth <d> nodes <n> pv <san>...
+// the score being Board::evaluate() for the player to move, or "mate <n>"
+// (negative when the player to move is mated) if the search found a mate in
+// n moves. The best move is "none" if the game is over, and the positions
+// with an illegal move get "<id> error <san>" instead ("<id> error FEN"
+// for an invalid FEN).
+
+#ifndef ANALYSIS_H_
+#define ANALYSIS_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "threadpool.h"
+
+// the size of the transposition table of each worker, in megabytes
+const size_t ANALYSIS_TT_MB = 16;
+
+struct AnalysisLimits {
+    // maximum depth of the search
+    int depth = 4;
+    // maximum nodes of the search, 0 for no limit, see Search::run()
+    long nodes = 0;
+};
+
+struct AnalysisJob {
+    std::string id;
+    // the FEN of the position the moves are played from, empty for the
+    // initial position
+    std::string fen;
+    // the moves played from the position above
+    std::vector<std::string> moves;
+    AnalysisLimits limits;
+    // if true, the positions after 0, 1, ... moves.size() moves are analysed,
+    // otherwise only the last one
+    bool every_position = false;
+};
+
+// reads the positions of filename (see above) and appends them to jobs, with
+// the limits defaults when a position doesn't set them.
+// returns false if the file can't be read.
+bool readAnalysisFile(const std::string &filename, const AnalysisLimits &defaults,
+                      std::vector<AnalysisJob> &jobs);
+
+struct AnalysisSummary {
+    // positions analysed, and positions with an illegal move
+    long positions = 0;
+    long errors = 0;
+    long nodes = 0;
+};
+
+// analyses the positions of jobs on the workers of pool, each one with a
+// transposition table of tt_mb megabytes, and writes their results on out
+// in the order of jobs, a job being written (and out flushed) as soon as it
+// and all the previous ones are analysed.
+AnalysisSummary analyzePositions(const std::vector<AnalysisJob> &jobs, ThreadPool &pool,
+                                 size_t tt_mb, std::ostream &out);
+
+#endif // ANALYSIS_H_
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include "arena.h"
+
+// returns the first address from p aligned on alignment (a power of 2)
+static char *align(char *p, size_t alignment) {
+    uintptr_t a = (uintptr_t) p;
+    return (char *) ((a + alignment - 1) & ~(uintptr_t) (alignment - 1));
+}
+
+Arena::Arena(size_t chunk_size) : chunk_size_(chunk_size) { }
+
+void Arena::rewindTo(const void *p) {
+    const char *q = (const char *) p;
+    // the chunks of the blocks allocated after p are left
+    while (chunk_ > 0 && (chunk_ >= chunks_.size() || q < chunks_[chunk_].data.get() ||
+                          q >= chunks_[chunk_].data.get() + chunks_[chunk_].size)) {
+        chunk_--;
+    }
+    const char *base = chunks_[chunk_].data.get();
+    assert(base <= q && q < base + chunks_[chunk_].size);
+    used_ = q - base;
+}
+
+size_t Arena::capacity() const {
+    size_t res = 0;
+    for (const auto &c : chunks_) {
+        res += c.size;
+    }
+    return res;
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment) {
+    if (chunk_ < chunks_.size()) {
+        Chunk &c = chunks_[chunk_];
+        char *p = align(c.data.get() + used_, alignment);
+        if (p + bytes <= c.data.get() + c.size) {
+            used_ = p + bytes - c.data.get();
+            return p;
+        }
+    }
+    return allocateInNextChunk(bytes, alignment);
+}
+
+void *Arena::allocateInNextChunk(size_t bytes, size_t alignment) {
+    // the chunks too small for the block are skipped, they are used again
+    // after the next rewind
+    size_t needed = bytes + alignment;
+    size_t next = (chunk_ < chunks_.size()) ? chunk_ + 1 : chunk_;
+    while (next < chunks_.size() && chunks_[next].size < needed) {
+        next++;
+    }
+    if (next == chunks_.size()) {
+        size_t size = std::max(chunk_size_, needed);
+        chunks_.push_back({std::unique_ptr<char[]>(new char[size]), size});
+    }
+    chunk_ = next;
+    char *base = chunks_[chunk_].data.get();
+    char *p = align(base, alignment);
+    used_ = p + bytes - base;
+    return p;
+}
+
+Arena &threadArena() {
+    static thread_local Arena arena;
+    return arena;
+}
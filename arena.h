@@ -0,0 +1,123 @@
+// This module implements the arenas, where the short-lived objects of the
+// search and of the games are allocated without calling the heap: an arena
+// hands out the memory of large chunks by moving a pointer forward (bump
+// allocation), and frees it all at once by moving the pointer back to a
+// mark taken before (see ArenaScope). The chunks are kept for the next
+// allocations, so an arena used the same way again and again, e.g. at each
+// node of a search, stays the same size.
+// see https://en.wikipedia.org/wiki/Region-based_memory_management
+//
+// An Arena is a std::pmr::memory_resource: the standard containers of
+// std::pmr take it as allocator, e.g. a MoveList (see global.h). Freeing a
+// single block does nothing, the memory comes back at the next rewind: a
+// container of an arena must not grow after a mark taken before its last
+// growth is rewound, see ArenaScope.
+//
+// An arena is used by one thread at a time. Each thread has its own, for
+// the containers that only live during a call (see threadArena()); a Board
+// has one for its pieces, and a Game one for its openings.
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+// the size of the chunks of an arena, unless a block needs more
+const size_t ARENA_CHUNK_SIZE = 64 * 1024;
+
+class Arena : public std::pmr::memory_resource {
+public:
+    // the position of the next allocation in the arena
+    struct Mark {
+        size_t chunk;
+        size_t used;
+    };
+
+    explicit Arena(size_t chunk_size = ARENA_CHUNK_SIZE);
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    Mark mark() const {
+        return {chunk_, used_};
+    }
+
+    // frees all the blocks allocated since m was taken
+    void rewind(Mark m) {
+        chunk_ = m.chunk;
+        used_ = m.used;
+    }
+
+    // frees the block p and all those allocated after it
+    void rewindTo(const void *p);
+
+    // frees all the blocks, the chunks being kept
+    void release() {
+        rewind({0, 0});
+    }
+
+    // constructs a T in the arena. Its destructor is never called: the
+    // object is freed with the arena, with whatever it allocated there.
+    template <class T, class... Args>
+    T *make(Args &&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // the bytes of the chunks allocated
+    size_t capacity() const;
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *, size_t, size_t) override { }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    // the allocation of a block that doesn't fit in the current chunk
+    void *allocateInNextChunk(size_t bytes, size_t alignment);
+
+    std::vector<Chunk> chunks_;
+    size_t chunk_size_;
+    // the chunk of the next allocation, chunks_.size() if there is none yet,
+    // and the bytes already used in it
+    size_t chunk_ = 0;
+    size_t used_ = 0;
+};
+
+// Rewinds an arena, when it goes out of scope, to where it was when it was
+// created: all the blocks allocated in between are freed. The scopes of an
+// arena must be nested.
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena &arena) : arena_(arena), mark_(arena.mark()) { }
+
+    ~ArenaScope() {
+        arena_.rewind(mark_);
+    }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+    Arena &arena_;
+    Arena::Mark mark_;
+};
+
+// the arena of the calling thread, for the containers that only live during
+// a call, in an ArenaScope (e.g. the moves of a node of the search)
+Arena &threadArena();
+
+#endif // ARENA_H_
@@ -0,0 +1,72 @@
+#include <chrono>
+#include <iomanip>
+#include <string>
+#include "bench.h"
+#include "board.h"
+#include "search.h"
+
+// the positions, in FEN (see Board::fromFEN())
+static const char *BENCH_POSITIONS[] = {
+    "rnbq1rk1/1p2ppbp/p1pp1np1/8/2PPP3/2N1BP2/PP1Q2PP/R3KBNR w KQ - 2 8",
+    "r4rk1/pp2pp1p/1qn2bp1/3p1b2/3P1P2/2P5/PP1NB1PP/R1Q1K1NR w KQ - 0 12",
+    "1br2rk1/3nqpp1/1p2pn1p/1Ppp1b2/2P5/1Q1PPN2/1B1NBPPP/2R2RK1 w - - 0 16",
+    "5rk1/p5pp/p3pp2/2Pn4/P2P4/1R2BP2/5P1P/6K1 w - - 0 21",
+    "2br2k1/1p4pp/1p1q1p2/8/1P1BP3/P4QP1/5P1P/3R2K1 w - - 0 26",
+    "7k/pr4p1/7p/6b1/1PRNp3/P3P2P/6P1/6K1 w - - 2 31",
+    "3R4/p6r/4kp2/2r1p1p1/1P6/2P1R1P1/P4P2/2K5 b - - 0 38",
+    "4r1k1/3n1pbp/3p2p1/3n4/2qNPP2/2pB1Q1P/1r4P1/2R2RBK b - - 1 25",
+    "rnb1kb1r/pp3ppp/1qpp1n2/8/3NPP2/2NB4/PPP3PP/R1BQK2R w KQkq - 1 8",
+    "r2q1rk1/p4ppp/b1n1pn2/2pp4/2P5/PPN1PQ2/4BPPP/R1B1K2R w KQ - 2 12",
+    "b3k2r/3n1ppp/1q1b1n2/1pp1pP2/1P2P3/3B1N2/2PBQ1PP/3NK2R w Kk - 0 16",
+    "4r1k1/1b1nqp2/5n1p/p1rp1Bp1/1p6/4PP2/PP1QNBPP/2R2R1K w - - 2 21",
+    "1r3rk1/6pp/2p2pb1/p1n1p3/P1N1Pn2/2P2PN1/1P1RB1PP/3R2K1 w - - 0 26",
+    "1k5r/1p6/7P/2p1q1p1/4p3/Pp2Pp1Q/2P2P2/1K1R4 w - - 0 31",
+    "5k2/1p3pp1/r1p4p/p1Rn4/P1N4P/1P2P1P1/4KP2/8 b - - 5 38",
+    "4k3/1b3p1p/6p1/4p3/1B2P3/P3K1P1/3R3P/1r6 w - - 12 46",
+    "rnbqkb1r/3p1ppp/pP6/2pp4/8/8/PP2PPPP/R1BQKBNR w KQkq - 0 8",
+    "r3k2r/ppqnbppp/2p2n2/4p2b/4P3/1P3NPP/PBP1QPB1/RN3RK1 w kq - 1 12",
+    "r3rbk1/pp1n1p1p/1qp2np1/3p2B1/3P4/P1N3PB/1PPQ1P1P/R4RK1 w - - 1 16",
+    "rq3rk1/3n1pbp/3pp1p1/NPpP4/p3P3/8/RP1BQPPP/R5K1 w - - 0 21",
+    "6k1/1p3pp1/2bR3p/p7/P7/1P2r1P1/4P2P/2R3K1 w - - 0 26",
+    "5r1k/pB4pp/5r2/4Q3/5P2/3q4/1P4PP/5RK1 w - - 0 31",
+    "4R3/p2r1p2/1p2k1p1/3n4/P2P2P1/3KN3/5P2/8 b - - 12 38",
+    "3rr1k1/1p3pp1/7p/8/3b2b1/1P1RB1P1/4PPKP/3R4 w - - 0 25",
+    "rnbqk2r/pp3pbp/3p1np1/2pP4/4P3/2N2N2/PP3PPP/R1BQKB1R w KQkq - 1 8",
+    "r1bq1rk1/pp2bpp1/2n1pn1p/8/2BP3B/2N5/PP2NPPP/R2Q1RK1 w - - 2 12",
+    "2rq1rk1/pb2bp1p/1pp1n1p1/3p3n/3P4/2NBPP2/PPQ1NBPP/3R1R1K w - - 6 16",
+    "2br1rk1/pp2qppp/1bp5/4n3/4P3/3B2PP/PPPBN1Q1/1K1R1R2 w - - 3 21",
+    "3r1bk1/ppq4p/2n2pp1/2P1p3/1P6/P4NP1/1B2QP1P/3R2K1 w - - 1 26",
+    "8/pp3R2/1knr1b1p/8/P3B3/2P2P1P/1P3K2/8 w - - 3 31",
+    "4r2k/6pp/2N1Nb2/p2P4/P1Q3K1/8/1q3PPP/8 w - - 11 37",
+    "6k1/pq4b1/3P1p1p/1p2pN1P/1Pp1Q1p1/P1P1K1P1/5P2/8 b - - 1 42",
+    "r1bqk1nr/pp3ppp/2n5/1Bbp4/8/5N2/PPPN1PPP/R1BQK2R w KQkq - 0 8",
+    "r1b2rk1/ppqnppbp/2p1n1p1/8/3PP3/5NP1/PPBN1P1P/R1BQ1RK1 w - - 1 12",
+    "r2q1rk1/pp2p2p/4bpp1/n2P4/4P3/3BBP2/P3N1PP/Q4RK1 w - - 0 16",
+    "r3r1k1/1b1p1pp1/2qp2n1/p6p/Pp1P2nP/1P1B1N1R/2PB1PP1/R2Q2K1 w - - 0 21",
+    "6k1/3n1p2/Q1pq2pp/3p4/3P4/4PN1P/5PP1/5K2 w - - 0 26",
+    "8/3Q1pk1/1qP5/1p1p1P1p/6p1/1Nb5/r5PP/4R2K w - - 2 31",
+    "1k1q4/ppb5/2p1pn2/2Pp1p2/1P1P1Pp1/3BP3/P1Q2P2/4B1K1 w - - 2 28",
+    "8/8/5k2/8/p4r1P/5p2/1P6/1K3R2 b - - 3 40",
+};
+
+BenchResult runBench(int depth, std::ostream &out) {
+    BenchResult res;
+    Board b;
+    Search search;
+    auto start = std::chrono::steady_clock::now();
+    for (const char *fen : BENCH_POSITIONS) {
+        res.positions++;
+        if (!b.fromFEN(fen)) {
+            out << "position " << res.positions << ": invalid FEN" << std::endl;
+            res.errors++;
+            continue;
+        }
+        SearchResult r = search.run(b, depth);
+        out << "position " << std::setw(2) << res.positions << ": "
+            << std::setw(9) << r.nodes << " nodes, score " << r.score << std::endl;
+        res.nodes += r.nodes;
+        deletePV(r, NULL);
+    }
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return res;
+}
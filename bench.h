@@ -0,0 +1,35 @@
+// This module implements the "bench" command: a fixed set of positions, taken
+// from the games of Akobian.pgn at various stages, is searched to a fixed
+// depth (see search.h).
+//
+// The search being deterministic, the total number of nodes is a signature:
+// it only changes when the behaviour of the search (move generation, ordering,
+// evaluation, pruning...) changes, not when the program gets faster or slower.
+// A change can thus be checked for speed (nodes/s) and for functional identity
+// (same signature) separately.
+//
+// The bench is also the workload used to train the profile-guided build
+// ("make pgo").
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <ostream>
+
+const int BENCH_DEPTH = 3;
+
+struct BenchResult {
+    // number of positions searched
+    int positions = 0;
+    // total number of nodes, the signature
+    long nodes = 0;
+    double seconds = 0;
+    // the positions whose FEN is not valid, they are not searched
+    int errors = 0;
+};
+
+// searches all the bench positions to depth plies, printing one line per
+// position on out, and returns the totals.
+BenchResult runBench(int depth, std::ostream &out);
+
+#endif // BENCH_H_
@@ -0,0 +1,257 @@
+#include <cassert>
+#include "bitboard.h"
+
+// the AVX2 fill moves 64-bit lanes to and from general registers, which only
+// x86-64 has: 32-bit x86 builds use the scalar fill
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BITBOARD_AVX2
+#include <immintrin.h>
+#endif
+
+// the magic numbers of the rooks and bishops, by square, for the fixed
+// shifts 64 - popcount(mask): each maps the occupancies of the mask to
+// distinct entries, or to entries with the same attacks
+static const uint64_t ROOK_MAGICS[64] = {
+    0x0080021620804001ULL, 0x0040001000200041ULL, 0x0200102200088040ULL,
+    0x4080040800821000ULL, 0x2200020004200810ULL, 0x4B00020C000D0008ULL,
+    0x01000C4183000600ULL, 0x2080010000402C80ULL, 0x8002800826864000ULL,
+    0x0410802000884000ULL, 0x0C01004010200100ULL, 0x020300100100203CULL,
+    0x0450800801040080ULL, 0x4010800200040080ULL, 0x8804000208048110ULL,
+    0x0C40800080004100ULL, 0xA2018880024004A0ULL, 0x0080848020004004ULL,
+    0x1010410010200101ULL, 0x2010008008008010ULL, 0x0A08010004110008ULL,
+    0x0802080104209040ULL, 0x0080040090010802ULL, 0x0280020000841069ULL,
+    0x080C400080248000ULL, 0x2048850100224008ULL, 0x00200800C0300040ULL,
+    0x11400D0100201000ULL, 0x0041001100080204ULL, 0x4802000200040810ULL,
+    0x0100080C00103601ULL, 0x0020084200043085ULL, 0x0100804000800022ULL,
+    0x0460401000402002ULL, 0x8309002001001044ULL, 0x0000800800801000ULL,
+    0x0000800800800400ULL, 0xB542040080800200ULL, 0x1041000401000200ULL,
+    0x000318B04A000401ULL, 0x0280082000484000ULL, 0x0080400081010030ULL,
+    0x0010002000108080ULL, 0x012010002101000AULL, 0x0801000408010012ULL,
+    0x0004008002008004ULL, 0x0AD1005200110014ULL, 0x4000004110820004ULL,
+    0x9400400080003080ULL, 0x0000802200490200ULL, 0x1521100080200280ULL,
+    0x9021000824100100ULL, 0x0081080080840280ULL, 0x0002000904100200ULL,
+    0x0130024801302400ULL, 0x0102008100442200ULL, 0x0080984063800101ULL,
+    0x0016810201412812ULL, 0x40200101603008C1ULL, 0x2851100004082101ULL,
+    0x1049001002880005ULL, 0x0081000804000201ULL, 0x100020901208410CULL,
+    0x0101064400813102ULL
+};
+
+static const uint64_t BISHOP_MAGICS[64] = {
+    0x24E0440C00802202ULL, 0x00881808841A4500ULL, 0x29C1021085004190ULL,
+    0x18C4041080042020ULL, 0x0841104000008108ULL, 0x890828080880C088ULL,
+    0x0006021024062018ULL, 0x2000404044104040ULL, 0x09000504104A0210ULL,
+    0x0088390204040820ULL, 0x4001420082008402ULL, 0x028108048B001142ULL,
+    0x1C00140421001008ULL, 0x0008021212200400ULL, 0x080000581A082004ULL,
+    0x3000048208027204ULL, 0x0120004044148482ULL, 0x4021000808108090ULL,
+    0x0084011808009452ULL, 0x11C802242020E000ULL, 0x0124002210140002ULL,
+    0x4009008200420200ULL, 0x0000830202100202ULL, 0x9002042500420200ULL,
+    0x0A60200004480210ULL, 0x0402481020480080ULL, 0x8001100101004200ULL,
+    0x6240104004004080ULL, 0x1124848014002000ULL, 0x00180200204100A0ULL,
+    0x8020890844880800ULL, 0x0000802009040204ULL, 0x0410042041100280ULL,
+    0x0804022000020440ULL, 0x2418280400480024ULL, 0x0801080800420A00ULL,
+    0x4002248400020020ULL, 0x3020004102038084ULL, 0x84280110601C0200ULL,
+    0x2004004208088080ULL, 0x0008022220041210ULL, 0x00820E0120000440ULL,
+    0x0002002201020822ULL, 0x0000002019000804ULL, 0x0211204C10101100ULL,
+    0x0604808081001200ULL, 0x1010029204030041ULL, 0x1008090102110621ULL,
+    0x0002015002100C00ULL, 0x06002C040404400AULL, 0xC030002201100011ULL,
+    0x4040008020884000ULL, 0x0248000903040100ULL, 0xC010092008008040ULL,
+    0x6008084108020494ULL, 0x28102182008E0042ULL, 0x0010210820842002ULL,
+    0x4080020111491002ULL, 0x0108100084008800ULL, 0x0022242100420221ULL,
+    0x10A8008110020210ULL, 0x400019122A900102ULL, 0x00800A1051080300ULL,
+    0x0420222088008080ULL
+};
+
+// the attacks of all the squares: 4096 occupancies at most for a rook
+// (12 squares in its mask), 512 for a bishop
+static Bitboard rook_table[102400];
+static Bitboard bishop_table[5248];
+
+const AttackTables attackTables;
+
+static bool isInside(int i, int j) {
+    return i >= 0 && i < 8 && j >= 0 && j < 8;
+}
+
+// the squares reached from sq in the directions di, dj, stopping on the
+// first occupied square (included), or one step if slide is false
+static Bitboard walk(int sq, const int di[], const int dj[], int count, bool slide,
+                     Bitboard occupied) {
+    Bitboard res = 0;
+    for (int k = 0; k < count; k++) {
+        int i = sq / 8 + di[k];
+        int j = sq % 8 + dj[k];
+        while (isInside(i, j)) {
+            res |= squareBit(8 * i + j);
+            if (!slide || (occupied & squareBit(8 * i + j))) {
+                break;
+            }
+            i += di[k];
+            j += dj[k];
+        }
+    }
+    return res;
+}
+
+static const int BISHOP_DI[4] = {-1, 1, 1, -1};
+static const int BISHOP_DJ[4] = {-1, 1, -1, 1};
+static const int ROOK_DI[4] = {-1, 1, 0, 0};
+static const int ROOK_DJ[4] = {0, 0, -1, 1};
+
+// fills the magics m of the slider of directions di, dj and their attacks in
+// table
+static void initMagics(Magic m[64], Bitboard *table, const uint64_t magics[64],
+                       const int di[4], const int dj[4]) {
+    Bitboard *attacks = table;
+    for (int sq = 0; sq < 64; sq++) {
+        // the edges are in the mask only on the line of the square
+        Bitboard edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * (sq / 8)))) |
+                         ((FILE_A | FILE_H) & ~(FILE_A << (sq % 8)));
+        m[sq].mask = walk(sq, di, dj, 4, true, 0) & ~edges;
+        m[sq].magic = magics[sq];
+        m[sq].shift = 64 - popcount(m[sq].mask);
+        m[sq].attacks = attacks;
+        // all the subsets of the mask (Carry-Rippler)
+        Bitboard occupied = 0;
+        do {
+            Bitboard a = walk(sq, di, dj, 4, true, occupied);
+            Bitboard &entry = attacks[m[sq].index(occupied)];
+            assert(entry == 0 || entry == a);
+            entry = a;
+            occupied = (occupied - m[sq].mask) & m[sq].mask;
+        } while (occupied != 0);
+        attacks += 1ULL << popcount(m[sq].mask);
+    }
+}
+
+AttackTables::AttackTables() {
+    static const int KNIGHT_DI[8] = {2, 1, 2, -1, -2, 1, -2, -1};
+    static const int KNIGHT_DJ[8] = {1, 2, -1, 2, 1, -2, -1, -2};
+    static const int KING_DI[8] = {-1, 1, 1, -1, -1, 0, 1, 0};
+    static const int KING_DJ[8] = {-1, 1, -1, 1, 0, -1, 0, 1};
+    static const int PAWN_DI[2][2] = {{-1, -1}, {1, 1}};
+    static const int PAWN_DJ[2] = {-1, 1};
+    for (int sq = 0; sq < 64; sq++) {
+        knight[sq] = walk(sq, KNIGHT_DI, KNIGHT_DJ, 8, false, 0);
+        king[sq] = walk(sq, KING_DI, KING_DJ, 8, false, 0);
+        for (int c = 0; c < 2; c++) {
+            pawn[c][sq] = walk(sq, PAWN_DI[c], PAWN_DJ, 2, false, 0);
+        }
+    }
+    initMagics(bishop, bishop_table, BISHOP_MAGICS, BISHOP_DI, BISHOP_DJ);
+    initMagics(rook, rook_table, ROOK_MAGICS, ROOK_DI, ROOK_DJ);
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            between[a][b] = 0;
+            line[a][b] = 0;
+            Bitboard to = squareBit(b);
+            if (a == b) {
+                continue;
+            }
+            if (bishopAttacks(a, 0) & to) {
+                between[a][b] = bishopAttacks(a, to) & bishopAttacks(b, squareBit(a));
+                line[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | squareBit(a) | to;
+            } else if (rookAttacks(a, 0) & to) {
+                between[a][b] = rookAttacks(a, to) & rookAttacks(b, squareBit(a));
+                line[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | squareBit(a) | to;
+            }
+        }
+    }
+}
+
+// the squares reached from the squares of gen in direction D, the squares
+// of empty letting the fill through, and the first blocker included
+template <Direction D>
+static Bitboard fill(Bitboard gen, Bitboard empty) {
+    // the squares a step of D may reach: a step to the east can't land on
+    // file A, one to the west on file H
+    constexpr Bitboard inside = (D == EAST || D == NORTH_EAST || D == SOUTH_EAST) ? ~FILE_A :
+                                (D == WEST || D == NORTH_WEST || D == SOUTH_WEST) ? ~FILE_H : ~0ULL;
+    constexpr int s = (D > 0) ? D : -D;
+    auto step = [](Bitboard b, int n) { return (D > 0) ? b << n : b >> n; };
+    Bitboard pro = empty & inside;
+    gen |= pro & step(gen, s);
+    pro &= step(pro, s);
+    gen |= pro & step(gen, 2 * s);
+    pro &= step(pro, 2 * s);
+    gen |= pro & step(gen, 4 * s);
+    return inside & step(gen, s);
+}
+
+Bitboard slidingAttacksScalar(Bitboard diagonal, Bitboard straight, Bitboard occupied) {
+    Bitboard empty = ~occupied;
+    return fill<NORTH>(straight, empty) | fill<SOUTH>(straight, empty) |
+           fill<EAST>(straight, empty) | fill<WEST>(straight, empty) |
+           fill<NORTH_EAST>(diagonal, empty) | fill<NORTH_WEST>(diagonal, empty) |
+           fill<SOUTH_EAST>(diagonal, empty) | fill<SOUTH_WEST>(diagonal, empty);
+}
+
+#ifdef BITBOARD_AVX2
+// the lanes are the directions NORTH, EAST, NORTH_EAST and NORTH_WEST when
+// shifted to the left, SOUTH, WEST, SOUTH_WEST and SOUTH_EAST to the right
+__attribute__((target("avx2")))
+Bitboard slidingAttacksAvx2(Bitboard diagonal, Bitboard straight, Bitboard occupied) {
+    const __m256i shift1 = _mm256_setr_epi64x(8, 1, 9, 7);
+    const __m256i shift2 = _mm256_setr_epi64x(16, 2, 18, 14);
+    const __m256i shift4 = _mm256_setr_epi64x(32, 4, 36, 28);
+    const __m256i inside_up = _mm256_setr_epi64x(~0ULL, ~FILE_A, ~FILE_A, ~FILE_H);
+    const __m256i inside_down = _mm256_setr_epi64x(~0ULL, ~FILE_H, ~FILE_H, ~FILE_A);
+    __m256i empty = _mm256_set1_epi64x(~occupied);
+    __m256i gen = _mm256_setr_epi64x(straight, straight, diagonal, diagonal);
+
+    __m256i up = gen;
+    __m256i pro = _mm256_and_si256(empty, inside_up);
+    up = _mm256_or_si256(up, _mm256_and_si256(pro, _mm256_sllv_epi64(up, shift1)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift1));
+    up = _mm256_or_si256(up, _mm256_and_si256(pro, _mm256_sllv_epi64(up, shift2)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift2));
+    up = _mm256_or_si256(up, _mm256_and_si256(pro, _mm256_sllv_epi64(up, shift4)));
+    up = _mm256_and_si256(inside_up, _mm256_sllv_epi64(up, shift1));
+
+    __m256i down = gen;
+    pro = _mm256_and_si256(empty, inside_down);
+    down = _mm256_or_si256(down, _mm256_and_si256(pro, _mm256_srlv_epi64(down, shift1)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift1));
+    down = _mm256_or_si256(down, _mm256_and_si256(pro, _mm256_srlv_epi64(down, shift2)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift2));
+    down = _mm256_or_si256(down, _mm256_and_si256(pro, _mm256_srlv_epi64(down, shift4)));
+    down = _mm256_and_si256(inside_down, _mm256_srlv_epi64(down, shift1));
+
+    __m256i all = _mm256_or_si256(up, down);
+    __m128i half = _mm_or_si128(_mm256_castsi256_si128(all), _mm256_extracti128_si256(all, 1));
+    return _mm_cvtsi128_si64(half) | _mm_extract_epi64(half, 1);
+}
+
+bool hasAvx2() {
+    // it may be called by static initializers, before the features are known
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#else
+Bitboard slidingAttacksAvx2(Bitboard diagonal, Bitboard straight, Bitboard occupied) {
+    return slidingAttacksScalar(diagonal, straight, occupied);
+}
+
+bool hasAvx2() {
+    return false;
+}
+#endif
+
+Bitboard slidingAttacksMagic(Bitboard diagonal, Bitboard straight, Bitboard occupied) {
+    Bitboard res = 0;
+    while (diagonal) {
+        res |= bishopAttacks(popLsb(diagonal), occupied);
+    }
+    while (straight) {
+        res |= rookAttacks(popLsb(straight), occupied);
+    }
+    return res;
+}
+
+typedef Bitboard (*SlidingAttacks)(Bitboard, Bitboard, Bitboard);
+
+static const SlidingAttacks sliding_attacks =
+    hasAvx2() ? slidingAttacksAvx2 : slidingAttacksScalar;
+
+Bitboard slidingAttacks(Bitboard diagonal, Bitboard straight, Bitboard occupied) {
+    return sliding_attacks(diagonal, straight, occupied);
+}
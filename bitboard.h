@@ -0,0 +1,217 @@
+// This module defines the bitboards, the sets of squares stored in 64 bits,
+// and the attacks of the pieces computed on them. A square is numbered
+// 8 * rank + file, from a1 (0) to h8 (63), as in Position {rank, file}.
+//
+// The attacks of the knights, kings and pawns are looked up in tables. Those
+// of the bishops, rooks and queens depend on the occupied squares of their
+// lines: they are looked up in tables indexed by a magic multiplication of
+// those squares (fixed-shift "fancy" magic bitboards). The magic numbers
+// were found once by trial and error and are stored in bitboard.cpp.
+// see https://www.chessprogramming.org/Magic_Bitboards
+
+#ifndef BITBOARD_H_
+#define BITBOARD_H_
+
+#include <cstdint>
+#include "global.h"
+
+typedef uint64_t Bitboard;
+
+const Bitboard FILE_A = 0x0101010101010101ULL;
+const Bitboard FILE_H = FILE_A << 7;
+const Bitboard RANK_1 = 0xFFULL;
+const Bitboard RANK_2 = RANK_1 << 8;
+const Bitboard RANK_3 = RANK_1 << 16;
+const Bitboard RANK_6 = RANK_1 << 40;
+const Bitboard RANK_7 = RANK_1 << 48;
+const Bitboard RANK_8 = RANK_1 << 56;
+
+inline int square(Position p) {
+    return 8 * p.first + p.second;
+}
+
+inline Position squarePosition(int sq) {
+    return {(unsigned int) sq / 8, (unsigned int) sq % 8};
+}
+
+inline Bitboard squareBit(int sq) {
+    return 1ULL << sq;
+}
+
+inline int popcount(Bitboard b) {
+    return __builtin_popcountll(b);
+}
+
+// the lowest square of b, which must not be empty
+inline int lsb(Bitboard b) {
+    return __builtin_ctzll(b);
+}
+
+// removes the lowest square of b, which must not be empty, and returns it
+inline int popLsb(Bitboard &b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// the shifts of a square one step in each direction
+enum Direction { NORTH = 8, SOUTH = -8, EAST = 1, WEST = -1,
+                 NORTH_EAST = 9, NORTH_WEST = 7, SOUTH_EAST = -7, SOUTH_WEST = -9 };
+
+// moves all the squares of b one step in direction D, those leaving the
+// board being dropped
+template <Direction D>
+constexpr Bitboard shift(Bitboard b) {
+    if constexpr (D == NORTH) {
+        return b << 8;
+    } else if constexpr (D == SOUTH) {
+        return b >> 8;
+    } else if constexpr (D == EAST) {
+        return (b & ~FILE_H) << 1;
+    } else if constexpr (D == WEST) {
+        return (b & ~FILE_A) >> 1;
+    } else if constexpr (D == NORTH_EAST) {
+        return (b & ~FILE_H) << 9;
+    } else if constexpr (D == NORTH_WEST) {
+        return (b & ~FILE_A) << 7;
+    } else if constexpr (D == SOUTH_EAST) {
+        return (b & ~FILE_H) >> 7;
+    } else {
+        return (b & ~FILE_A) >> 9;
+    }
+}
+
+// the squares attacked by the pawns of color c on the squares of pawns
+inline Bitboard pawnsAttacks(Color c, Bitboard pawns) {
+    return (c == WHITE) ? shift<NORTH_EAST>(pawns) | shift<NORTH_WEST>(pawns) :
+                          shift<SOUTH_EAST>(pawns) | shift<SOUTH_WEST>(pawns);
+}
+
+// the squares attacked by the knights on the squares of knights
+inline Bitboard knightsAttacks(Bitboard knights) {
+    Bitboard one = shift<EAST>(knights) | shift<WEST>(knights);
+    Bitboard two = shift<EAST>(shift<EAST>(knights)) | shift<WEST>(shift<WEST>(knights));
+    return (one << 16) | (one >> 16) | (two << 8) | (two >> 8);
+}
+
+// the squares attacked by the kings on the squares of kings
+inline Bitboard kingsAttacks(Bitboard kings) {
+    Bitboard sides = shift<EAST>(kings) | shift<WEST>(kings);
+    Bitboard row = sides | kings;
+    return sides | (row << 8) | (row >> 8);
+}
+
+// the lookup tables of the slider attacks of one square
+struct Magic {
+    // the squares of the lines whose occupation matters: the board edges are
+    // left out, a slider is stopped there anyway
+    Bitboard mask;
+    uint64_t magic;
+    // the attacks, indexed by ((occupied & mask) * magic) >> shift
+    const Bitboard *attacks;
+    int shift;
+
+    unsigned int index(Bitboard occupied) const {
+        return ((occupied & mask) * magic) >> shift;
+    }
+};
+
+struct AttackTables {
+    Bitboard knight[64];
+    Bitboard king[64];
+    // pawn[c][sq]: the squares a pawn of color c on sq attacks
+    Bitboard pawn[2][64];
+    // the squares strictly between two squares on a line, 0 if they are not
+    // on a line
+    Bitboard between[64][64];
+    // the squares of the lines (rank, file or diagonal) through two squares,
+    // the two squares included, 0 if they are not on a line
+    Bitboard line[64][64];
+    Magic bishop[64];
+    Magic rook[64];
+
+    AttackTables();
+};
+
+extern const AttackTables attackTables;
+
+inline Bitboard knightAttacks(int sq) {
+    return attackTables.knight[sq];
+}
+
+inline Bitboard kingAttacks(int sq) {
+    return attackTables.king[sq];
+}
+
+inline Bitboard pawnAttacks(Color c, int sq) {
+    return attackTables.pawn[c][sq];
+}
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    const Magic &m = attackTables.bishop[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+    const Magic &m = attackTables.rook[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+    return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+}
+
+inline Bitboard between(int a, int b) {
+    return attackTables.between[a][b];
+}
+
+inline Bitboard line(int a, int b) {
+    return attackTables.line[a][b];
+}
+
+// the attacks of a piece of type T (not a pawn) on sq
+template <PieceType T>
+inline Bitboard attacks(int sq, Bitboard occupied) {
+    if constexpr (T == KNIGHT) {
+        return knightAttacks(sq);
+    } else if constexpr (T == BISHOP) {
+        return bishopAttacks(sq, occupied);
+    } else if constexpr (T == ROOK) {
+        return rookAttacks(sq, occupied);
+    } else if constexpr (T == QUEEN) {
+        return queenAttacks(sq, occupied);
+    } else {
+        static_assert(T == KING, "the pawn attacks depend on the color");
+        return kingAttacks(sq);
+    }
+}
+
+// The attacks of all the sliders of a side at once, for the attack maps (see
+// Board::attackMap()): the squares attacked by the pieces on the squares of
+// diagonal (bishops and queens) along the diagonals, and by those of straight
+// (rooks and queens) along the ranks and files, the squares of occupied
+// stopping them. The 8 directions are filled set-wise, by Kogge-Stone
+// parallel prefix: 3 shifts of doubling length per direction, whatever the
+// number of sliders.
+// see https://www.chessprogramming.org/Kogge-Stone_Algorithm
+//
+// slidingAttacks() calls slidingAttacksAvx2() if the CPU has AVX2, checked
+// once at startup, and slidingAttacksScalar() otherwise. The other versions
+// compute the same set, to compare them (see microbench.cpp).
+Bitboard slidingAttacks(Bitboard diagonal, Bitboard straight, Bitboard occupied);
+
+// the 8 directions one after the other, on 64-bit integers
+Bitboard slidingAttacksScalar(Bitboard diagonal, Bitboard straight, Bitboard occupied);
+
+// the 4 directions toward the higher squares in the 4 lanes of an AVX2
+// register, then the 4 others. Must only be called if hasAvx2().
+Bitboard slidingAttacksAvx2(Bitboard diagonal, Bitboard straight, Bitboard occupied);
+
+// one lookup in the magic tables per slider, and two per queen
+Bitboard slidingAttacksMagic(Bitboard diagonal, Bitboard straight, Bitboard occupied);
+
+// returns true if the CPU runs AVX2 instructions, and
+// slidingAttacksAvx2() is compiled in (on x86-64 with GCC or Clang)
+bool hasAvx2();
+
+#endif // BITBOARD_H_
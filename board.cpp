@@ -1,14 +1,74 @@
 #include "board.h"
 #include "piece.h"
-#include "concretepieces.h"
+#include "movegen.h"
+#include "eval.h"
 #include <vector>
 #include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <cstring>
+#include <cctype>
 #include <utility>
 #include <string>
 
+// The random keys used for the Zobrist hashing: one per piece type (indexed
+// by PieceType - 1), color and position, one for the player, one per
+// castling right and one per file of the en passant square.
+// They are drawn by a fixed generator (splitmix64), so the keys, and the
+// files that store them, are the same on every run.
+
+struct ZobristKeys {
+    uint64_t pieces[6][2][8][8];
+    uint64_t white_to_play;
+    // castling[r] is the xor of the keys of the rights ored in r
+    uint64_t castling[16];
+    uint64_t en_passant[8];
+
+    ZobristKeys() {
+        uint64_t state = 0x2545F4914F6CDD1DULL;
+        for (int t = 0; t < 6; t++) {
+            for (int c = 0; c < 2; c++) {
+                for (int i = 0; i < 8; i++) {
+                    for (int j = 0; j < 8; j++) {
+                        pieces[t][c][i][j] = next(state);
+                    }
+                }
+            }
+        }
+        white_to_play = next(state);
+        uint64_t rights[4];
+        for (int r = 0; r < 4; r++) {
+            rights[r] = next(state);
+        }
+        for (int r = 0; r < 16; r++) {
+            castling[r] = 0;
+            for (int k = 0; k < 4; k++) {
+                castling[r] ^= (r & (1 << k)) ? rights[k] : 0;
+            }
+        }
+        for (int j = 0; j < 8; j++) {
+            en_passant[j] = next(state);
+        }
+    }
+
+    static uint64_t next(uint64_t &state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t piece(Position pos, const Piece *p) const {
+        return pieces[p->type() - 1][p->getColor()][pos.first][pos.second];
+    }
+
+    uint64_t state(int rights, int en_passant) const {
+        return castling[rights] ^ (en_passant >= 0 ? this->en_passant[en_passant % 8] : 0);
+    }
+};
+
+static const ZobristKeys zobrist;
+
 int pawn_strength(Piece *p) {
   """
   returns the weight of the pawn depending on its position
@@ -51,15 +111,22 @@ int Board::heuristic() {
     calculates the heuristic value at this point of the game
     as explained in the report
     """
-    int sign[2] = {1, -1};
-    int res = 0;
-    std::vector<Move *> moves = getAllLegalMoves();
-    if (moves.size() == 0) {
+    if (!hasLegalMove()) {
+      // a stalemate is a draw
+      if (!isInCheck(current_player_)) {
+        return 0;
+      }
       if (current_player_ == BLACK) {
         return INF;
       }
       return MINF;
     }
+    return evaluate();
+}
+
+int Board::evaluate() const {
+    int sign[2] = {1, -1};
+    int res = 0;
     for (size_t i = 0; i < 2; i++) {
       for (auto p : pieces_[i]) {
         if (p->isCaptured()) {
@@ -101,7 +168,15 @@ int Board::heuristic() {
         }
       }
     }
-    return res;
+    return res + evaluateTerms(*this, eval_terms_);
+}
+
+void Board::setEvalTerms(int terms) {
+    eval_terms_ = terms;
+}
+
+int Board::evalTerms() const {
+    return eval_terms_;
 }
 
 bool Board::isInside(int i, int j) const {
@@ -153,35 +228,516 @@ void Board::filter(Position start, const std::vector<Position> &rel, Color pl,
     }
 }
 
+int Board::attackersTo(Position to, Color pl, char n, Piece *res[8]) const {
+    int count = 0;
+    int ti = to.first;
+    int tj = to.second;
+    if (n == ' ') {
+        // a white pawn attacks upwards, so it stands one rank below its target
+        int di = (pl == WHITE) ? -1 : 1;
+        int dj[] = {-1, 1};
+        for (int k = 0; k < 2; k++) {
+            int si = ti + di;
+            int sj = tj + dj[k];
+            if (!isInside(si, sj)) {
+                continue;
+            }
+            Piece *p = board_[si][sj];
+            if (p != NULL && p->getColor() == pl && p->notation() == n) {
+                res[count++] = p;
+            }
+        }
+        return count;
+    }
+    int knight_di[] = {2, 1, 2, -1, -2, 1, -2, -1};
+    int knight_dj[] = {1, 2, -1, 2, 1, -2, -1, -2};
+    int line_di[] = {-1, 1, 1, -1, -1, 0, 1, 0};
+    int line_dj[] = {-1, 1, -1, 1, 0, -1, 0, 1};
+    int *di = (n == 'N') ? knight_di : line_di;
+    int *dj = (n == 'N') ? knight_dj : line_dj;
+    int max = (n == 'N' || n == 'K') ? 1 : 8;
+    // the first four directions are diagonals, the last four are lines
+    int first = (n == 'R') ? 4 : 0;
+    int last = (n == 'B') ? 4 : 8;
+    for (int k = first; k < last; k++) {
+        int si = ti;
+        int sj = tj;
+        for (int step = 0; step < max; step++) {
+            si += di[k];
+            sj += dj[k];
+            if (!isInside(si, sj)) {
+                break;
+            }
+            Piece *p = board_[si][sj];
+            if (p == NULL) {
+                continue;
+            }
+            if (p->getColor() == pl && p->notation() == n) {
+                res[count++] = p;
+            }
+            break;
+        }
+    }
+    return count;
+}
+
 Board::Board() {
     memset(board_, (int) NULL, 64 * sizeof(Piece *));
     for (int i = 0; i < 8; i++) {
-        board_[6][i] = addPiece(new Pawn({6,i}, BLACK));
-        board_[1][i] = addPiece(new Pawn({1,i}, WHITE));
+        board_[6][i] = addPiece({6,i}, BLACK, PAWN);
+        board_[1][i] = addPiece({1,i}, WHITE, PAWN);
+    }
+
+    board_[7][0] = addPiece({7,0}, BLACK, ROOK);
+    board_[7][1] = addPiece({7,1}, BLACK, KNIGHT);
+    board_[7][2] = addPiece({7,2}, BLACK, BISHOP);
+    board_[7][3] = addPiece({7,3}, BLACK, QUEEN);
+    board_[7][4] = king_[BLACK] = addPiece({7,4}, BLACK, KING);
+    board_[7][5] = addPiece({7,5}, BLACK, BISHOP);
+    board_[7][6] = addPiece({7,6}, BLACK, KNIGHT);
+    board_[7][7] = addPiece({7,7}, BLACK, ROOK);
+
+    board_[0][0] = addPiece({0,0}, WHITE, ROOK);
+    board_[0][1] = addPiece({0,1}, WHITE, KNIGHT);
+    board_[0][2] = addPiece({0,2}, WHITE, BISHOP);
+    board_[0][3] = addPiece({0,3}, WHITE, QUEEN);
+    board_[0][4] = king_[WHITE] = addPiece({0,4}, WHITE, KING);
+    board_[0][5] = addPiece({0,5}, WHITE, BISHOP);
+    board_[0][6] = addPiece({0,6}, WHITE, KNIGHT);
+    board_[0][7] = addPiece({0,7}, WHITE, ROOK);
+    initial_pieces_ = pieces_arena_.mark();
+    state_ = {0, WHITE_KING_SIDE | WHITE_QUEEN_SIDE | BLACK_KING_SIDE | BLACK_QUEEN_SIDE, -1, 0, 0};
+    computeHash();
+    computeBitboards();
+}
+
+void Board::reset() {
+    memset(board_, (int) NULL, 64 * sizeof(Piece *));
+    // pieces_[c] starts with the 8 pawns, then the pieces of the first line
+    // from file A to file H, as created by Board()
+    unsigned int pawn_line[2] = {6, 1};
+    unsigned int first_line[2] = {7, 0};
+    pieces_arena_.rewind(initial_pieces_);
+    for (int c = 0; c < 2; c++) {
+        pieces_[c].resize(16);
+        for (unsigned int k = 0; k < 16; k++) {
+            Position pos = (k < 8) ? Position(pawn_line[c], k) : Position(first_line[c], k - 8);
+            Piece *p = pieces_[c][k];
+            p->setPosition(pos);
+            p->setCaptured(false);
+            board_[pos.first][pos.second] = p;
+        }
+    }
+    current_player_ = WHITE;
+    achieved_moves_.clear();
+    state_ = {0, WHITE_KING_SIDE | WHITE_QUEEN_SIDE | BLACK_KING_SIDE | BLACK_QUEEN_SIDE, -1, 0, 0};
+    history_.clear();
+    computeHash();
+    computeBitboards();
+}
+
+// the type of the piece of FEN letter c, its PieceType - 1, or -1 if c is not
+// a piece
+static int fenType(char c) {
+    switch (c) {
+      case 'P': case 'p':
+        return 0;
+      case 'N': case 'n':
+        return 1;
+      case 'B': case 'b':
+        return 2;
+      case 'R': case 'r':
+        return 3;
+      case 'Q': case 'q':
+        return 4;
+      case 'K': case 'k':
+        return 5;
+      default:
+        return -1;
+    }
+}
+
+// the indices in pieces_[c] of the pieces of the initial set, by type, in
+// the order of Board()
+static const int INITIAL_SLOTS[6][8] = {{0, 1, 2, 3, 4, 5, 6, 7}, {9, 14}, {10, 13},
+                                        {8, 15}, {11}, {12}};
+static const int INITIAL_COUNT[6] = {8, 2, 2, 2, 1, 1};
+
+// copies the next field of s (a FEN), separated by spaces, to field, and
+// moves s after it. Returns false if there is no field or it is longer than
+// size - 1.
+static bool nextField(const char *&s, char *field, size_t size) {
+    while (*s == ' ') {
+        s++;
+    }
+    size_t n = 0;
+    for (; *s != ' ' && *s != '\0'; s++) {
+        if (n + 1 >= size) {
+            return false;
+        }
+        field[n++] = *s;
+    }
+    field[n] = '\0';
+    return n > 0;
+}
+
+// reads the counter of a FEN from field into *n, returns false if field is
+// not a number
+static bool readCounter(const char *field, int *n) {
+    *n = 0;
+    for (const char *d = field; *d != '\0'; d++) {
+        if (*d < '0' || *d > '9') {
+            return false;
+        }
+        *n = 10 * *n + (*d - '0');
+    }
+    return true;
+}
+
+bool Board::fromFEN(const std::string &fen) {
+    // the pieces of the initial set are reused (see INITIAL_SLOTS), the
+    // others (promoted) are freed
+    pieces_arena_.rewind(initial_pieces_);
+    for (int c = 0; c < 2; c++) {
+        pieces_[c].resize(16);
+        for (auto p : pieces_[c]) {
+            p->setCaptured(true);
+        }
+    }
+    memset(board_, (int) NULL, 64 * sizeof(Piece *));
+    achieved_moves_.clear();
+    history_.clear();
+    // the pieces of each type and color placed so far
+    int placed[2][6] = {{0}};
+    int count[2] = {0, 0};
+    // the hash of the pieces, computed as they are placed
+    uint64_t hash = 0;
+    const char *s = fen.c_str();
+    int i = 7;
+    int j = 0;
+    bool ok = true;
+    for (; ok && *s != ' ' && *s != '\0'; s++) {
+        int type = fenType(*s);
+        if (*s == '/') {
+            ok = j == 8 && i > 0;
+            i--;
+            j = 0;
+        } else if (*s >= '1' && *s <= '8') {
+            j += *s - '0';
+            ok = j <= 8;
+        } else if (type >= 0 && j < 8) {
+            Color c = (*s >= 'A' && *s <= 'Z') ? WHITE : BLACK;
+            Position pos = {(unsigned int) i, (unsigned int) j};
+            int n = placed[c][type]++;
+            ok = ++count[c] <= 16 && !(type == 0 && (i == 0 || i == 7 || n >= 8)) &&
+                 !(type == 5 && n > 0);
+            Piece *p;
+            if (n < INITIAL_COUNT[type]) {
+                p = pieces_[c][INITIAL_SLOTS[type][n]];
+                p->setPosition(pos);
+                p->setCaptured(false);
+            } else {
+                p = addPiece(pos, c, PieceType(type + 1));
+            }
+            board_[i][j] = p;
+            hash ^= zobrist.pieces[type][c][i][j];
+            j++;
+        } else {
+            ok = false;
+        }
+    }
+    ok = ok && i == 0 && j == 8 && placed[WHITE][5] == 1 && placed[BLACK][5] == 1;
+
+    // player, castling rights, en passant square and counters (optional)
+    char player[2];
+    char castling[5];
+    char en_passant[3];
+    char counter[8];
+    int halfmove = 0;
+    int fullmove = 1;
+    ok = ok && nextField(s, player, sizeof(player)) && (player[0] == 'w' || player[0] == 'b') &&
+         nextField(s, castling, sizeof(castling)) && nextField(s, en_passant, sizeof(en_passant));
+    if (ok && nextField(s, counter, sizeof(counter))) {
+        ok = readCounter(counter, &halfmove) &&
+             (!nextField(s, counter, sizeof(counter)) || readCounter(counter, &fullmove));
+    }
+    if (!ok) {
+        reset();
+        return false;
+    }
+    current_player_ = (player[0] == 'w') ? WHITE : BLACK;
+    state_.castling = 0;
+    const char *rights = "KQkq";
+    for (const char *r = castling; *r != '\0' && *r != '-'; r++) {
+        const char *k = strchr(rights, *r);
+        if (k == NULL) {
+            reset();
+            return false;
+        }
+        state_.castling |= 1 << (k - rights);
+    }
+    // the rights are kept if the king and the rook are in place
+    for (int k = 0; k < 4; k++) {
+        Color c = (k < 2) ? WHITE : BLACK;
+        unsigned int line = (c == WHITE) ? 0 : 7;
+        Piece *king = board_[line][4];
+        Piece *rook = board_[line][(k % 2 == 0) ? 7 : 0];
+        if (king == NULL || king->notation() != 'K' || king->getColor() != c ||
+            rook == NULL || rook->notation() != 'R' || rook->getColor() != c) {
+            state_.castling &= ~(1 << k);
+        }
+    }
+    // the en passant square is kept if the player can take a pawn there
+    state_.en_passant = -1;
+    if (en_passant[0] >= 'a' && en_passant[0] <= 'h' && en_passant[1] == ((current_player_ == WHITE) ? '6' : '3')) {
+        unsigned int to_i = en_passant[1] - '1';
+        unsigned int to_j = en_passant[0] - 'a';
+        unsigned int pawn_i = (current_player_ == WHITE) ? 4 : 3;
+        Piece *pawn = board_[pawn_i][to_j];
+        bool taker = false;
+        for (int dj = -1; dj <= 1; dj += 2) {
+            Piece *p = isInside(pawn_i, (int) to_j + dj) ? board_[pawn_i][to_j + dj] : NULL;
+            taker = taker || (p != NULL && p->notation() == ' ' && p->getColor() == current_player_);
+        }
+        if (pawn != NULL && pawn->notation() == ' ' && pawn->getColor() != current_player_ &&
+            board_[to_i][to_j] == NULL && taker) {
+            state_.en_passant = to_i * 8 + to_j;
+        }
+    } else if (strcmp(en_passant, "-") != 0) {
+        reset();
+        return false;
+    }
+    state_.halfmove_clock = std::max(0, halfmove);
+    state_.ply = 2 * (std::max(1, fullmove) - 1) + (current_player_ == BLACK ? 1 : 0);
+    computeBitboards();
+    hash_ = hash ^ ((current_player_ == WHITE) ? zobrist.white_to_play : 0) ^
+            zobrist.state(state_.castling, state_.en_passant);
+    if (isInCheck(current_player_ == WHITE ? BLACK : WHITE)) {
+        reset();
+        return false;
+    }
+    return true;
+}
+
+std::string Board::toFEN() const {
+    std::string fen;
+    for (int i = 7; i >= 0; i--) {
+        int empty = 0;
+        for (int j = 0; j < 8; j++) {
+            Piece *p = board_[i][j];
+            if (p == NULL) {
+                empty++;
+                continue;
+            }
+            if (empty > 0) {
+                fen += (char) ('0' + empty);
+                empty = 0;
+            }
+            char n = (p->notation() == ' ') ? 'P' : p->notation();
+            fen += (p->getColor() == WHITE) ? n : (char) tolower(n);
+        }
+        if (empty > 0) {
+            fen += (char) ('0' + empty);
+        }
+        if (i > 0) {
+            fen += '/';
+        }
+    }
+    fen += (current_player_ == WHITE) ? " w " : " b ";
+    const char *rights = "KQkq";
+    for (int k = 0; k < 4; k++) {
+        if (state_.castling & (1 << k)) {
+            fen += rights[k];
+        }
+    }
+    if (state_.castling == 0) {
+        fen += '-';
+    }
+    fen += ' ';
+    if (state_.en_passant >= 0) {
+        fen += (char) ('a' + state_.en_passant % 8);
+        fen += (char) ('1' + state_.en_passant / 8);
+    } else {
+        fen += '-';
+    }
+    fen += " " + std::to_string(state_.halfmove_clock) + " " + std::to_string(fullmoveNumber());
+    return fen;
+}
+
+int Board::castlingRights() const {
+    return state_.castling;
+}
+
+bool Board::enPassant(Position *pos) const {
+    if (state_.en_passant < 0) {
+        return false;
+    }
+    *pos = {(unsigned int) state_.en_passant / 8, (unsigned int) state_.en_passant % 8};
+    return true;
+}
+
+int Board::halfmoveClock() const {
+    return state_.halfmove_clock;
+}
+
+int Board::fullmoveNumber() const {
+    return state_.ply / 2 + 1;
+}
+
+// the castling rights kept when a piece leaves or reaches the square 8*i + j:
+// those of the king and rooks that are not on their initial square
+static uint8_t castlingMask(Position pos) {
+    switch (pos.first * 8 + pos.second) {
+      case 0:
+        return ~WHITE_QUEEN_SIDE & 15;
+      case 4:
+        return ~(WHITE_KING_SIDE | WHITE_QUEEN_SIDE) & 15;
+      case 7:
+        return ~WHITE_KING_SIDE & 15;
+      case 56:
+        return ~BLACK_QUEEN_SIDE & 15;
+      case 60:
+        return ~(BLACK_KING_SIDE | BLACK_QUEEN_SIDE) & 15;
+      case 63:
+        return ~BLACK_KING_SIDE & 15;
+      default:
+        return 15;
+    }
+}
+
+void Board::saveState(Position from, Position to, const Piece *moved, bool capture) {
+    history_.push_back(state_);
+    history_.back().key = hash_;
+    State s = state_;
+    s.castling &= castlingMask(from) & castlingMask(to);
+    s.en_passant = -1;
+    s.halfmove_clock++;
+    if (moved->notation() == ' ') {
+        s.halfmove_clock = 0;
+        // a pawn that advances two squares can be taken en passant if a pawn
+        // of the other player stands next to its destination
+        bool taker = false;
+        for (int dj = -1; dj <= 1 && (from.first + 2 == to.first || to.first + 2 == from.first);
+             dj += 2) {
+            Piece *p = isInside(to.first, (int) to.second + dj) ?
+                       board_[to.first][to.second + dj] : NULL;
+            taker = taker || (p != NULL && p->notation() == ' ' &&
+                              p->getColor() != moved->getColor());
+        }
+        if (taker) {
+            s.en_passant = (from.first + to.first) / 2 * 8 + from.second;
+        }
+    } else if (capture) {
+        s.halfmove_clock = 0;
+    }
+    s.ply++;
+    setState(s);
+}
+
+bool Board::isRepetition(int count) const {
+    // the positions with the same player to move, 4 plies ago or more: 2
+    // plies can't bring a position back
+    int n = history_.size();
+    int plies = std::min<int>(state_.halfmove_clock, n);
+    for (int i = 4; i <= plies; i += 2) {
+        if (history_[n - i].key == hash_ && --count == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Board::isInsufficientMaterial() const {
+    int minors = 0;
+    for (size_t i = 0; i < 2; i++) {
+        for (auto p : pieces_[i]) {
+            if (p->isCaptured()) {
+                continue;
+            }
+            switch (p->notation()) {
+              case 'K':
+                break;
+              case 'N':
+              case 'B':
+                if (++minors > 1) {
+                    return false;
+                }
+                break;
+              default:
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Board::isDraw(int count) const {
+    return state_.halfmove_clock >= 100 || isRepetition(count) || isInsufficientMaterial();
+}
+
+void Board::restoreState() {
+    setState(history_.back());
+    history_.pop_back();
+}
+
+void Board::setState(const State &s) {
+    hash_ ^= zobrist.state(state_.castling, state_.en_passant) ^
+             zobrist.state(s.castling, s.en_passant);
+    state_ = s;
+}
+
+void Board::computeHash() {
+    hash_ = (current_player_ == WHITE) ? zobrist.white_to_play : 0;
+    hash_ ^= zobrist.state(state_.castling, state_.en_passant);
+    for (unsigned int i = 0; i < 8; i++) {
+        for (unsigned int j = 0; j < 8; j++) {
+            if (board_[i][j] != NULL) {
+                hash_ ^= zobrist.piece({i, j}, board_[i][j]);
+            }
+        }
     }
+}
 
-    board_[7][0] = addPiece(new Rook({7,0}, BLACK));
-    board_[7][1] = addPiece(new Knight({7,1}, BLACK));
-    board_[7][2] = addPiece(new Bishop({7,2}, BLACK));
-    board_[7][3] = addPiece(new Queen({7,3}, BLACK));
-    board_[7][4] = king_[BLACK] = addPiece(new King({7,4}, BLACK));
-    board_[7][5] = addPiece(new Bishop({7,5}, BLACK));
-    board_[7][6] = addPiece(new Knight({7,6}, BLACK));
-    board_[7][7] = addPiece(new Rook({7,7}, BLACK));
+// the squares attacked by a piece of code on sq
+static Bitboard attacksFrom(PieceCode code, int sq, Bitboard occupied) {
+    switch (pieceType(code)) {
+      case PAWN:
+        return pawnAttacks(pieceColor(code), sq);
+      case KNIGHT:
+        return knightAttacks(sq);
+      case BISHOP:
+        return bishopAttacks(sq, occupied);
+      case ROOK:
+        return rookAttacks(sq, occupied);
+      case QUEEN:
+        return queenAttacks(sq, occupied);
+      default:
+        return kingAttacks(sq);
+    }
+}
 
-    board_[0][0] = addPiece(new Rook({0,0}, WHITE));
-    board_[0][1] = addPiece(new Knight({0,1}, WHITE));
-    board_[0][2] = addPiece(new Bishop({0,2}, WHITE));
-    board_[0][3] = addPiece(new Queen({0,3}, WHITE));
-    board_[0][4] = king_[WHITE] = addPiece(new King({0,4}, WHITE));
-    board_[0][5] = addPiece(new Bishop({0,5}, WHITE));
-    board_[0][6] = addPiece(new Knight({0,6}, WHITE));
-    board_[0][7] = addPiece(new Rook({0,7}, WHITE));
+void Board::computeBitboards() {
+    memset(bitboards_, 0, sizeof(bitboards_));
+    memset(occupancy_, 0, sizeof(occupancy_));
+    for (int sq = 0; sq < 64; sq++) {
+        Piece *p = pieceAt(sq);
+        if (p != NULL) {
+            bitboards_[p->code()] |= squareBit(sq);
+            occupancy_[p->getColor()] |= squareBit(sq);
+        }
+    }
+    if (track_attacks_) {
+        computeAttacks(attack_counts_);
+    }
+}
 
+uint64_t Board::hash() const {
+    return hash_;
 }
 
-Piece * Board::addPiece(Piece *p) {
-  pieces_[p->getColor()].push_back(p);
+Piece *Board::addPiece(Position pos, Color c, PieceType type) {
+  Piece *p = pieces_arena_.make<Piece>(pos, c, type);
+  pieces_[c].push_back(p);
   return p;
 }
 
@@ -191,6 +747,7 @@ Color Board::getPlayer() const {
 
 void Board::switch_player() {
     current_player_ = current_player_?BLACK:WHITE;
+    hash_ ^= zobrist.white_to_play;
 }
 
 void Board::display() {
@@ -215,7 +772,7 @@ void Board::display() {
     if (isInCheck(BLACK)) {
         std::cout << "Black is checked" << std::endl;
     }
-    if (getAllLegalMoves().size() == 0) {
+    if (!hasLegalMove()) {
         std::cout << "Game over" << std::endl;
     }
 
@@ -321,38 +878,249 @@ void Board::displayCaptured(){
 }
 
 std::vector<Move *> Board::getAllMoves(Color player) const {
-        std::vector<Move *> moves;
-        for (auto p : pieces_[player]) {
-            if (p->isCaptured()) {
-                continue;
-            }
-            p->getMoves(*this, moves);
-        }
-        return moves;
+    Arena &arena = threadArena();
+    ArenaScope scope(arena);
+    MoveList moves(&arena);
+    generateMoves(*this, player, ALL, moves);
+    return std::vector<Move *>(moves.begin(), moves.end());
 }
 
 std::vector<Move *> Board::getAllMoves() const {
         return getAllMoves(current_player_);
 }
 
-std::vector<Move *> Board::getAllLegalMoves() {
+std::vector<Move *> Board::getAllLegalMoves(GenType type) {
+    Arena &arena = threadArena();
+    ArenaScope scope(arena);
+    MoveList moves(&arena);
+    getAllLegalMoves(type, moves);
+    return std::vector<Move *>(moves.begin(), moves.end());
+}
+
+void Board::getAllLegalMoves(GenType type, MoveList &res) {
         int line[2] = {7, 0};
         int color = (int) current_player_;
-        std::vector<Move *> moves = getAllMoves();
-        std::vector<Move *> res;
-        for (auto x : moves) {
-            if (isLegal(x)) {
-                res.push_back(x);
-           }
+        bool in_check = isInCheck(current_player_);
+        size_t first = res.size();
+        generateMoves(*this, current_player_, in_check ? EVASIONS : type, res);
+        // the legal moves are kept in place
+        size_t kept_end = first;
+        for (size_t k = first; k < res.size(); k++) {
+            Move *x = res[k];
+            // the evasions are of both kinds
+            bool kept = !in_check || type == ALL || type == EVASIONS ||
+                        (x->doesCapture(NULL) || x->isPromotion()) == (type == CAPTURES);
+            if (kept && (!mayExposeKing(x, in_check) || isLegal(x))) {
+                res[kept_end++] = x;
+            } else {
+                delete x;
+            }
+        }
+        res.resize(kept_end);
+        if (in_check || type == CAPTURES) {
+            return;
         }
         if ((*this).castling_permitted(board_[line[color]][4], board_[line[color]][7], 2, line[color])) {
             Castling *move = new Castling(board_[line[color]][4], board_[line[color]][7]);
             res.push_back(move);
-        } else if ((*this).castling_permitted(board_[line[color]][4], board_[line[color]][0], 3, line[color])) {
+        }
+        if ((*this).castling_permitted(board_[line[color]][4], board_[line[color]][0], 3, line[color])) {
             Castling *move = new Castling(board_[line[color]][4], board_[line[color]][0]);
             res.push_back(move);
         }
-        return res;
+}
+
+// the number of legal moves of the pawns of player Us, whose turn it is, on
+// the squares of pawns, which are not pinned, to the squares of target, en
+// passant aside: a promotion counts as 4 moves
+template <Color Us>
+static int countPawnMoves(const Board &b, Bitboard pawns, Bitboard target) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    constexpr Direction Up = (Us == WHITE) ? NORTH : SOUTH;
+    constexpr Direction UpEast = (Us == WHITE) ? NORTH_EAST : SOUTH_EAST;
+    constexpr Direction UpWest = (Us == WHITE) ? NORTH_WEST : SOUTH_WEST;
+    constexpr Bitboard Rank3 = (Us == WHITE) ? RANK_3 : RANK_6;
+    constexpr Bitboard Rank8 = (Us == WHITE) ? RANK_8 : RANK_1;
+    Bitboard empty = ~b.occupancy();
+    Bitboard push = shift<Up>(pawns) & empty;
+    Bitboard push2 = shift<Up>(push & Rank3) & empty & target;
+    Bitboard enemies = b.occupancy(Them) & target;
+    Bitboard moves[3] = {push & target, shift<UpEast>(pawns) & enemies,
+                         shift<UpWest>(pawns) & enemies};
+    int count = popcount(push2);
+    for (Bitboard m : moves) {
+        count += popcount(m & ~Rank8) + 4 * popcount(m & Rank8);
+    }
+    return count;
+}
+
+// the number of legal moves of the pieces of type T of player us, whose turn
+// it is, masks being those of Board::legalMasks()
+template <PieceType T>
+static int countPieceMoves(const Board &b, Color us, const LegalMasks &masks) {
+    Bitboard occupied = b.occupancy();
+    int count = 0;
+    for (Bitboard pieces = b.pieces(pieceCode(T, us)); pieces;) {
+        int from = popLsb(pieces);
+        Bitboard tos = attacks<T>(from, occupied) & masks.target;
+        if (masks.pinned & squareBit(from)) {
+            tos &= line(masks.king, from);
+        }
+        count += popcount(tos);
+    }
+    return count;
+}
+
+bool Board::hasLegalMove() {
+    LegalMasks masks = legalMasks();
+    return kingTargets(masks) != 0 || countNonKingMoves(masks) != 0;
+}
+
+int Board::countLegalMoves() {
+    LegalMasks masks = legalMasks();
+    return popcount(kingTargets(masks)) + popcount(castlingTargets(masks)) +
+           countNonKingMoves(masks);
+}
+
+int Board::countNonKingMoves(const LegalMasks &masks) const {
+    Color us = current_player_;
+    int count = 0;
+    Bitboard pawns = bitboards_[pieceCode(PAWN, us)];
+    if (us == WHITE) {
+        count += countPawnMoves<WHITE>(*this, pawns & ~masks.pinned, masks.target);
+    } else {
+        count += countPawnMoves<BLACK>(*this, pawns & ~masks.pinned, masks.target);
+    }
+    for (Bitboard pinned = pawns & masks.pinned; pinned;) {
+        int from = popLsb(pinned);
+        Bitboard tos = pawnTargets(from, masks.target) & line(masks.king, from);
+        count += popcount(tos) + 3 * popcount(tos & (RANK_1 | RANK_8));
+    }
+    Position ep;
+    if (enPassant(&ep)) {
+        int to = square(ep);
+        for (Bitboard takers = pawns & pawnAttacks(us ? BLACK : WHITE, to); takers;) {
+            count += enPassantLegal(popLsb(takers), to);
+        }
+    }
+    count += countPieceMoves<KNIGHT>(*this, us, masks);
+    count += countPieceMoves<BISHOP>(*this, us, masks);
+    count += countPieceMoves<ROOK>(*this, us, masks);
+    count += countPieceMoves<QUEEN>(*this, us, masks);
+    return count;
+}
+
+LegalMasks Board::legalMasks() const {
+    Color us = current_player_;
+    Color them = us ? BLACK : WHITE;
+    LegalMasks masks;
+    masks.king = lsb(bitboards_[pieceCode(KING, us)]);
+    masks.checkers = attackers(masks.king, them);
+    masks.target = ~occupancy_[us];
+    if (masks.checkers & (masks.checkers - 1)) {
+        masks.target = 0;
+    } else if (masks.checkers) {
+        masks.target &= between(masks.king, lsb(masks.checkers)) | masks.checkers;
+    }
+    // a piece is pinned if it is alone between the king and a slider that
+    // would attack the king on an empty board
+    Bitboard occupied = occupancy();
+    Bitboard queens = bitboards_[pieceCode(QUEEN, them)];
+    Bitboard snipers = (rookAttacks(masks.king, 0) & (bitboards_[pieceCode(ROOK, them)] | queens)) |
+                       (bishopAttacks(masks.king, 0) & (bitboards_[pieceCode(BISHOP, them)] | queens));
+    masks.pinned = 0;
+    while (snipers) {
+        Bitboard blockers = between(masks.king, popLsb(snipers)) & occupied;
+        if (blockers && !(blockers & (blockers - 1))) {
+            masks.pinned |= blockers & occupancy_[us];
+        }
+    }
+    return masks;
+}
+
+Bitboard Board::legalTargets(int from, const LegalMasks &masks) const {
+    if (from == masks.king) {
+        return kingTargets(masks) | castlingTargets(masks);
+    }
+    Piece *p = pieceAt(from);
+    Bitboard res;
+    if (p->type() == PAWN) {
+        res = pawnTargets(from, masks.target);
+    } else {
+        res = attacksFrom(p->code(), from, occupancy()) & masks.target;
+    }
+    if (masks.pinned & squareBit(from)) {
+        res &= line(masks.king, from);
+    }
+    Position ep;
+    if (p->type() == PAWN && enPassant(&ep) &&
+        (pawnAttacks(current_player_, from) & squareBit(square(ep))) &&
+        enPassantLegal(from, square(ep))) {
+        res |= squareBit(square(ep));
+    }
+    return res;
+}
+
+Bitboard Board::kingTargets(const LegalMasks &masks) const {
+    Color them = current_player_ ? BLACK : WHITE;
+    // the king doesn't stop the sliders that attack it from the squares
+    // behind it
+    Bitboard attacked = attackMap(them, occupancy() ^ squareBit(masks.king));
+    return kingAttacks(masks.king) & ~occupancy_[current_player_] & ~attacked;
+}
+
+Bitboard Board::castlingTargets(const LegalMasks &masks) const {
+    if (masks.checkers) {
+        return 0;
+    }
+    int line = (current_player_ == WHITE) ? 0 : 7;
+    Bitboard res = 0;
+    if (castling_permitted(board_[line][4], board_[line][7], 2, line)) {
+        res |= squareBit(8 * line + 6);
+    }
+    if (castling_permitted(board_[line][4], board_[line][0], 3, line)) {
+        res |= squareBit(8 * line + 2);
+    }
+    return res;
+}
+
+Bitboard Board::pawnTargets(int from, Bitboard target) const {
+    Color us = current_player_;
+    int up = (us == WHITE) ? 8 : -8;
+    Bitboard empty = ~occupancy();
+    Bitboard res = squareBit(from + up) & empty;
+    if (res && (squareBit(from) & ((us == WHITE) ? RANK_2 : RANK_7))) {
+        res |= squareBit(from + 2 * up) & empty;
+    }
+    res |= pawnAttacks(us, from) & occupancy_[us ? BLACK : WHITE];
+    return res & target;
+}
+
+bool Board::enPassantLegal(int from, int to) const {
+    Color us = current_player_;
+    int taken = to + ((us == WHITE) ? -8 : 8);
+    // both pawns leave their squares, which may open a line to the king
+    Bitboard occupied = (occupancy() ^ squareBit(from) ^ squareBit(taken)) | squareBit(to);
+    int king = lsb(bitboards_[pieceCode(KING, us)]);
+    return (attackers(king, us ? BLACK : WHITE, occupied) & ~squareBit(taken)) == 0;
+}
+
+bool Board::mayExposeKing(const Move *m, bool in_check) const {
+    const Piece *p = m->getMoved();
+    if (in_check || p == king_[current_player_]) {
+        return true;
+    }
+    Position k = king_[current_player_]->getPosition();
+    Position from = m->getFrom();
+    int di = (int) from.first - (int) k.first;
+    int dj = (int) from.second - (int) k.second;
+    if (di == 0 || dj == 0 || di == dj || di == -dj) {
+        return true;
+    }
+    // a pawn that moves diagonally to an empty square takes en passant
+    Position to = m->getTo();
+    return p->notation() == ' ' && from.second != to.second &&
+           board_[to.first][to.second] == NULL;
 }
 
 bool Board::isLegal(Move *m) {
@@ -370,23 +1138,164 @@ bool Board::getPiece(Position pos, Piece **p) const {
 
 void Board::setPiece(Position pos, Piece *p) {
     assert(p);
+    removePiece(pos);
     board_[pos.first][pos.second] = p;
+    hash_ ^= zobrist.piece(pos, p);
+    int sq = square(pos);
+    Bitboard bit = squareBit(sq);
+    Bitboard occupied = occupancy();
+    bitboards_[p->code()] |= bit;
+    occupancy_[p->getColor()] |= bit;
+    if (track_attacks_) {
+        // the piece stops the sliders whose lines go through its square
+        updateSliderRays(sq, -1);
+        addAttacks(p->getColor(), attacksFrom(p->code(), sq, occupied), 1);
+    }
+#ifdef BOARD_VERIFY
+    assert(verifyAttacks());
+#endif
 }
 
 void Board::removePiece(Position pos) {
+    Piece *p = board_[pos.first][pos.second];
+    if (p != NULL) {
+        hash_ ^= zobrist.piece(pos, p);
+        int sq = square(pos);
+        Bitboard bit = squareBit(sq);
+        Bitboard occupied = occupancy();
+        bitboards_[p->code()] &= ~bit;
+        occupancy_[p->getColor()] &= ~bit;
+        if (track_attacks_) {
+            addAttacks(p->getColor(), attacksFrom(p->code(), sq, occupied), -1);
+            updateSliderRays(sq, 1);
+        }
+    }
     board_[pos.first][pos.second] = NULL;
+#ifdef BOARD_VERIFY
+    assert(verifyAttacks());
+#endif
+}
+
+void Board::trackAttacks(bool on) {
+    track_attacks_ = on;
+    if (on) {
+        computeAttacks(attack_counts_);
+    }
+}
+
+void Board::computeAttacks(Bitboard counts[2][ATTACK_COUNT_BITS]) const {
+    memset(counts, 0, 2 * ATTACK_COUNT_BITS * sizeof(Bitboard));
+    Bitboard occupied = occupancy();
+    for (Bitboard pieces = occupied; pieces;) {
+        int sq = popLsb(pieces);
+        Piece *p = pieceAt(sq);
+        for (Bitboard a = attacksFrom(p->code(), sq, occupied); a;) {
+            int to = popLsb(a);
+            // increments the count of to, bit by bit
+            for (int k = 0; k < ATTACK_COUNT_BITS; k++) {
+                counts[p->getColor()][k] ^= squareBit(to);
+                if (counts[p->getColor()][k] & squareBit(to)) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool Board::verifyAttacks() const {
+    if (!track_attacks_) {
+        return true;
+    }
+    Bitboard counts[2][ATTACK_COUNT_BITS];
+    computeAttacks(counts);
+    return memcmp(counts, attack_counts_, sizeof(counts)) == 0;
+}
+
+void Board::addAttacks(Color c, Bitboard squares, int delta) {
+    Bitboard *count = attack_counts_[c];
+    // the carry of an addition, or the borrow of a subtraction, ripples
+    // through the bits
+    Bitboard carry = squares;
+    for (int k = 0; k < ATTACK_COUNT_BITS && carry; k++) {
+        Bitboard next = (delta > 0) ? count[k] & carry : ~count[k] & carry;
+        count[k] ^= carry;
+        carry = next;
+    }
+}
+
+void Board::updateSliderRays(int sq, int delta) {
+    Bitboard occupied = occupancy();
+    Bitboard queens = bitboards_[pieceCode(QUEEN, WHITE)] | bitboards_[pieceCode(QUEEN, BLACK)];
+    // the rays from sq, whose part away from each slider is its ray beyond sq
+    Bitboard diagonal = bishopAttacks(sq, occupied);
+    Bitboard straight = rookAttacks(sq, occupied);
+    Bitboard sliders = (diagonal & (bitboards_[pieceCode(BISHOP, WHITE)] |
+                                    bitboards_[pieceCode(BISHOP, BLACK)] | queens)) |
+                       (straight & (bitboards_[pieceCode(ROOK, WHITE)] |
+                                    bitboards_[pieceCode(ROOK, BLACK)] | queens));
+    while (sliders) {
+        int from = popLsb(sliders);
+        Bitboard ray = (diagonal & squareBit(from)) ? diagonal : straight;
+        Bitboard beyond = ray & line(from, sq) & ~between(from, sq) & ~squareBit(from);
+        addAttacks((occupancy_[WHITE] & squareBit(from)) ? WHITE : BLACK, beyond, delta);
+    }
+}
+
+int Board::attackCount(int sq, Color c) const {
+    if (!track_attacks_) {
+        return popcount(attackers(sq, c));
+    }
+    int count = 0;
+    for (int k = 0; k < ATTACK_COUNT_BITS; k++) {
+        count |= ((attack_counts_[c][k] >> sq) & 1) << k;
+    }
+    return count;
+}
+
+Bitboard Board::attackers(int sq, Color c) const {
+    return attackers(sq, c, occupancy());
+}
+
+Bitboard Board::attackers(int sq, Color c, Bitboard occupied) const {
+    Color other = c?BLACK:WHITE;
+    Bitboard queens = bitboards_[pieceCode(QUEEN, c)];
+    // a pawn of c attacks sq from the squares a pawn of the other player on
+    // sq would attack
+    return (pawnAttacks(other, sq) & bitboards_[pieceCode(PAWN, c)]) |
+           (knightAttacks(sq) & bitboards_[pieceCode(KNIGHT, c)]) |
+           (bishopAttacks(sq, occupied) & (bitboards_[pieceCode(BISHOP, c)] | queens)) |
+           (rookAttacks(sq, occupied) & (bitboards_[pieceCode(ROOK, c)] | queens)) |
+           (kingAttacks(sq) & bitboards_[pieceCode(KING, c)]);
+}
+
+Bitboard Board::attackMap(Color c) const {
+    if (track_attacks_) {
+        // the squares of non-zero count
+        Bitboard res = 0;
+        for (int k = 0; k < ATTACK_COUNT_BITS; k++) {
+            res |= attack_counts_[c][k];
+        }
+        return res;
+    }
+    return attackMap(c, occupancy());
+}
+
+Bitboard Board::attackMap(Color c, Bitboard occupied) const {
+    Bitboard queens = bitboards_[pieceCode(QUEEN, c)];
+    return pawnsAttacks(c, bitboards_[pieceCode(PAWN, c)]) |
+           knightsAttacks(bitboards_[pieceCode(KNIGHT, c)]) |
+           kingsAttacks(bitboards_[pieceCode(KING, c)]) |
+           slidingAttacks(bitboards_[pieceCode(BISHOP, c)] | queens,
+                          bitboards_[pieceCode(ROOK, c)] | queens, occupied);
 }
 
 bool Board::isInCheck(Color p) const {
     Color other = p?BLACK:WHITE;
-    std::vector<Move *> moves = getAllMoves(other);
-    Piece *k = king_[p];
-    for (auto m : moves) {
-        if (m->doesCapture(k)) {
-            return true;
-        }
+    int k = square(king_[p]->getPosition());
+    if (track_attacks_) {
+        return (attackMap(other) & squareBit(k)) != 0;
     }
-    return false;
+    return attackers(k, other) != 0;
 }
 
 void Board::add_to_achieved_moves(Move *move) {
@@ -408,26 +1317,43 @@ void Board::promote_pawn_b(Move *m, std::string last_member) {
     """
     Position pos = m->getPosition_promotion();
     int line[2] = {0, 7};
-    this->removePiece(pos);
     this->switch_player();
-    if (pos.first != line[current_player_]) {
+    if (pos.first != (unsigned int) line[current_player_]) {
       this->switch_player();
       return;
     }
+    // the pawn leaves the game, it must not generate moves anymore
+    board_[pos.first][pos.second]->setCaptured(true);
+    this->removePiece(pos);
 
     if (last_member == "B") {
-        board_[pos.first][pos.second] = addPiece(new Bishop({pos.first, pos.second}, current_player_));
+        setPiece(pos, addPiece(pos, current_player_, BISHOP));
     } else if (last_member == "R") {
-      board_[pos.first][pos.second] = addPiece(new Rook({pos.first, pos.second}, current_player_));
+      setPiece(pos, addPiece(pos, current_player_, ROOK));
     } else if (last_member == "Q") {
-      board_[pos.first][pos.second] = addPiece(new Queen({pos.first, pos.second}, current_player_));
+      setPiece(pos, addPiece(pos, current_player_, QUEEN));
     } else {
-      board_[pos.first][pos.second] = addPiece(new Knight({pos.first, pos.second}, current_player_));
+      setPiece(pos, addPiece(pos, current_player_, KNIGHT));
     }
     this->switch_player();
 }
 
-bool Board::castling_permitted(Piece *moved_k_, Piece *moved_r_, int moves_todo, int line) {
+void Board::unpromote_pawn_b(Move *m) {
+    Position pos = m->getPosition_promotion();
+    Piece *pawn = m->getMoved();
+    Piece *promoted = board_[pos.first][pos.second];
+    // the new piece is the last one added by promote_pawn_b()
+    assert(promoted == pieces_[pawn->getColor()].back());
+    removePiece(pos);
+    pieces_[pawn->getColor()].pop_back();
+    // the promotions are undone in the reverse order: promoted is the last
+    // piece of the arena
+    pieces_arena_.rewindTo(promoted);
+    pawn->setCaptured(false);
+    setPiece(pos, pawn);
+}
+
+bool Board::castling_permitted(Piece *moved_k_, Piece *moved_r_, int moves_todo, int line) const {
     """
     Checks if the castling move is permitted
     """
@@ -440,39 +1366,27 @@ bool Board::castling_permitted(Piece *moved_k_, Piece *moved_r_, int moves_todo,
     if ((moved_r_->notation() != 'R') || (moved_k_->notation() != 'K')) {
       return false;
     }
-    //Is the king in check
-    if ((*this).isInCheck()) {
+    if ((moved_r_->getColor() != current_player_) || (moved_k_->getColor() != current_player_)) {
+      return false;
+    }
+    //Has the player lost the right to castle on this side
+    int right = (moves_todo == 2) ? WHITE_KING_SIDE : WHITE_QUEEN_SIDE;
+    if (!(state_.castling & (current_player_ == WHITE ? right : right << 2))) {
       return false;
     }
     //Are the pieces between the king and rook empty ?
     for (int i = 1; i < moves_todo+1; i++) {
-      if (board_[line][4+i] != NULL) {
+      if (board_[line][4+i*dir] != NULL) {
         return false;
       }
     }
-    //Check if the king doesn't pass through or end up in a square that is
-    // under attack by an enemy piece
-    BasicMove move_1 = BasicMove({line, 4}, {line, 4 + dir}, moved_k_);
-    if (!((*this).isLegal(&move_1))) {
-      return false;
-    } else {
-      move_1.perform(this);
-      BasicMove move_2 = BasicMove({line, 4 + dir}, {line, 4 + 2*dir}, moved_k_);
-      if (!((*this).isLegal(&move_2))) {
-        move_1.unPerform(this);
-        return false;
-      } else if (moves_todo == 3) {
-        move_2.perform(this);
-        BasicMove move_3 = BasicMove({line, 4 + 2*dir}, {line, 4 + 3*dir}, moved_k_);
-        if (!((*this).isLegal(&move_3))) {
-          move_2.unPerform(this);
-          move_1.unPerform(this);
-          return false;
-        }
-        move_2.unPerform(this);
-      }
-      move_1.unPerform(this);
+    //Is the king in check, or does it pass through or end up in a square
+    // that is under attack by an enemy piece. The king only travels two
+    // squares, even on the queen side where the rook's neighbour must merely
+    // be empty.
+    Bitboard path = 0;
+    for (int i = 0; i <= 2; i++) {
+      path |= squareBit(8 * line + 4 + i * dir);
     }
-
-    return true;
+    return (attackMap(current_player_ ? BLACK : WHITE) & path) == 0;
 }
@@ -2,8 +2,12 @@
 #define BOARD_H_
 
 #include <vector>
+#include <cstdint>
+#include <string>
 #include "piece.h"
 #include "global.h"
+#include "bitboard.h"
+#include "arena.h"
 
 class Piece;
 class Move;
@@ -21,7 +25,7 @@ class Move;
 // Board b;
 // Piece *p;
 // b.getPiece({1,1}, &p);      // p contains now the pawn at position {1,1} (i.e. B2)
-// std::vector<Move *> moves;
+// MoveList moves;
 // p->getMoves(b, moves);     // fill moves with all possible moves for this piece
 // Move *m = moves[0];
 // m->perform(&b);            // move m is performed on board b
@@ -31,6 +35,50 @@ class Move;
 //
 // The moves computed by getMoves only work on board used to compute them
 //
+// Besides the pieces, the Board keeps the state that the pieces don't tell:
+// the castling rights, the en passant square and the move counters. Each
+// performed move saves it (see saveState()) and unperforming the move
+// restores it.
+//
+
+// the castling rights, see Board::castlingRights()
+enum CastlingRight { WHITE_KING_SIDE = 1, WHITE_QUEEN_SIDE = 2,
+                     BLACK_KING_SIDE = 4, BLACK_QUEEN_SIDE = 8 };
+
+// the initial position in the Forsyth-Edwards Notation, see Board::fromFEN()
+const char START_FEN[] = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// the score of a pawn in Board::evaluate(), e.g. to write the scores in
+// centipawns
+const int PAWN_SCORE = 3;
+
+// the terms of Board::evaluate() beyond the material and the placement of
+// the pieces, see eval.h
+enum EvalTerm { EVAL_MOBILITY = 1, EVAL_KING_SAFETY = 2, EVAL_PAWN_SHIELD = 4,
+                EVAL_ALL_TERMS = 7 };
+
+// the size of the chunks of the arena of the pieces of a Board, in bytes: the
+// initial set and several dozens of promotions
+const size_t PIECES_ARENA_CHUNK_SIZE = 1024;
+
+// the bits of the attack counts, see Board::attackCount()
+const int ATTACK_COUNT_BITS = 5;
+
+// what the legal moves of the player to move depend on, see
+// Board::legalMasks()
+struct LegalMasks {
+    // the square of the king
+    int king;
+    // the pieces that give check
+    Bitboard checkers;
+    // the squares the pieces other than the king may go to: those not taken
+    // by their own pieces and, in check, the checker and the squares between
+    // it and the king (none in double check)
+    Bitboard target;
+    // the pieces pinned on the king, which only move along their line
+    // through the king
+    Bitboard pinned;
+};
 
 class Board {
 public:
@@ -38,14 +86,105 @@ public:
     // according to the rules of the game.
     Board();
 
+    // puts the pieces back in their initial position, as after Board().
+    // The pieces created by promotions are deleted, and the achieved moves are
+    // forgotten, so that a Board can be reused for many games.
+    void reset();
+
+    // sets the position described by fen in the Forsyth-Edwards Notation,
+    // e.g. START_FEN: the pieces, the player, the castling rights, the en
+    // passant square and the two move counters, which may be omitted (EPD).
+    // see https://en.wikipedia.org/wiki/Forsyth%E2%80%93Edwards_Notation
+    // The Pieces of the Board are reused: the pieces of the initial set that
+    // are missing from fen are captured, and only the pieces beyond the
+    // initial set of a player (e.g. a second queen) are created. As with
+    // reset(), the achieved moves are forgotten.
+    // The castling rights whose king or rook is not on its initial square,
+    // and an en passant square without a pawn to take, are dropped.
+    // returns false, the board being left in the initial position, if fen
+    // is not valid or the player who just moved is in check.
+    bool fromFEN(const std::string &fen);
+
+    // returns the FEN of the current position
+    std::string toFEN() const;
+
+    // the CastlingRights left, ored
+    int castlingRights() const;
+
+    // returns true if a pawn can be taken en passant, and stores in *pos the
+    // square the taking pawn moves to
+    bool enPassant(Position *pos) const;
+
+    // plies since the last capture or pawn move, for the fifty-move rule
+    int halfmoveClock() const;
+
+    // the number of the current move: 1 at the start of the game, and
+    // incremented after each move of Black
+    int fullmoveNumber() const;
+
+    // returns true if the current position occurred count times before since
+    // the last capture or pawn move (once by default, twice for a threefold
+    // repetition). Only the positions reached by the moves performed on the
+    // board count, not those before fromFEN(). The plies since the last
+    // irreversible move are the only ones looked at.
+    bool isRepetition(int count = 1) const;
+
+    // returns true if neither player can mate: the kings are alone, or with
+    // a single knight or bishop
+    bool isInsufficientMaterial() const;
+
+    // returns true if the game is drawn, whatever the moves: by the
+    // fifty-move rule, a repetition (see isRepetition(count)) or insufficient
+    // material. A mate on the last move of the fifty-move rule is not
+    // checked.
+    bool isDraw(int count = 1) const;
+
+    // called by Move::perform() before the piece moved goes from `from` to
+    // `to`, capture being true if it takes a piece: saves the castling
+    // rights, the en passant square and the counters, and updates them.
+    void saveState(Position from, Position to, const Piece *moved, bool capture);
+
+    // called by Move::unPerform(): restores the state saved by the last
+    // saveState()
+    void restoreState();
+
     // returns all the moves that can be performed in the current state
     // of the game, this include some 'illegal' moves that would put the player
     // in check
     std::vector<Move *> getAllMoves() const;
 
-    // returns all the legal moves that can be performed in the current
-    // state of the game.
-    std::vector<Move *> getAllLegalMoves();
+    // returns all the legal moves of kind type (see GenType) that can be
+    // performed in the current state of the game: ALL of them by default, or
+    // the CAPTURES or QUIETS only. When the player is in check, the moves are
+    // taken from the EVASIONS, whatever the type.
+    std::vector<Move *> getAllLegalMoves(GenType type = ALL);
+
+    // push_back's on res the moves of getAllLegalMoves(type), without
+    // copying them: the list may be in an Arena (see arena.h), as in the
+    // search
+    void getAllLegalMoves(GenType type, MoveList &res);
+
+    // returns true if the player to move has a legal move: the king steps
+    // are tried first, then the other moves are counted as in
+    // countLegalMoves(). No move is created. Castling is not tried: when it
+    // is legal, the step of the king toward the rook is legal too.
+    bool hasLegalMove();
+
+    // returns the number of legal moves of the player to move, a promotion
+    // counting as 4 moves (one per new piece), as in perft. The squares the
+    // pieces may go to are counted on the bitboards (see legalMasks()), the
+    // pawns that are not pinned all at once: no move is created.
+    int countLegalMoves();
+
+    // computes the masks of the legal moves of the player to move: the
+    // checkers and the pinned pieces
+    LegalMasks legalMasks() const;
+
+    // the squares the piece of the player to move on square from may go to
+    // by a legal move, masks being those of legalMasks(): an en passant
+    // capture goes to the en passant square, and a castling moves the king
+    // two squares
+    Bitboard legalTargets(int from, const LegalMasks &masks) const;
 
     // A move is legal if after performing it, the current player is not in
     // check. Note: This method leaves the board as it found it, but can't
@@ -54,8 +193,71 @@ public:
 
     Color getPlayer() const;
 
+    // returns the Zobrist key of the current state: the pieces on the board,
+    // the current player, the castling rights and the en passant square. It
+    // is maintained incrementally by setPiece(), removePiece(),
+    // switch_player(), saveState() and restoreState().
+    // see https://en.wikipedia.org/wiki/Zobrist_hashing
+    uint64_t hash() const;
+
     bool getPiece(Position, Piece **) const;
 
+    // returns the piece on square sq (see bitboard.h), NULL if it is empty
+    Piece *pieceAt(int sq) const {
+        return board_[sq / 8][sq % 8];
+    }
+
+    // the squares of the pieces of code c (see PieceCode). The bitboards are
+    // maintained by setPiece() and removePiece(), as the hash.
+    Bitboard pieces(PieceCode c) const {
+        return bitboards_[c];
+    }
+
+    // the squares of the pieces of player c
+    Bitboard occupancy(Color c) const {
+        return occupancy_[c];
+    }
+
+    // the occupied squares
+    Bitboard occupancy() const {
+        return occupancy_[WHITE] | occupancy_[BLACK];
+    }
+
+    // the squares of the pieces of player c that attack square sq
+    Bitboard attackers(int sq, Color c) const;
+
+    // the same, the sliders being stopped by the squares of occupied instead
+    // of the pieces on the board
+    Bitboard attackers(int sq, Color c, Bitboard occupied) const;
+
+    // the squares attacked by the pieces of player c, see slidingAttacks()
+    Bitboard attackMap(Color c) const;
+
+    // the same, computed from scratch, the sliders being stopped by the
+    // squares of occupied instead of the pieces on the board
+    Bitboard attackMap(Color c, Bitboard occupied) const;
+
+    // The attack maps may be maintained incrementally, to be read by
+    // attackMap(), attackCount() and isInCheck() without being computed.
+    // setPiece() and removePiece() then update the attacks of the piece and
+    // of the sliders whose lines go through its square, and no other. It is
+    // off by default: the updates cost more than they save when the maps are
+    // only read for the check tests (see microbench.cpp). Turning it on
+    // computes the maps from scratch.
+    void trackAttacks(bool on);
+
+    bool tracksAttacks() const {
+        return track_attacks_;
+    }
+
+    // the number of pieces of player c that attack square sq
+    int attackCount(int sq, Color c) const;
+
+    // returns true if the maintained attack maps are those computed from
+    // scratch, or if they are not maintained. Built with VERIFY=1 (see the
+    // Makefile), setPiece() and removePiece() assert it.
+    bool verifyAttacks() const;
+
     void setPiece(Position, Piece *);
 
     void removePiece(Position);
@@ -72,11 +274,23 @@ public:
     // player. A stricly positive score means that White is winning.
     // heuristic() == INF <=> Black is checkmate
     // heuristic() == MINF <=> White is checkmate
+    // A stalemate scores 0.
     // A simple way to compute this heuristic is to count the pieces captured
     // by each player. Other ingredients can be added, such as the control of
     // the central positions
     int heuristic();
 
+    // returns the part of heuristic() computed from the pieces only: their
+    // material and position, and the terms of evalTerms(). It doesn't check
+    // whether the game is over.
+    int evaluate() const;
+
+    // the EvalTerms ored that evaluate() computes, all of them by default.
+    // They are kept by reset() and fromFEN().
+    void setEvalTerms(int terms);
+
+    int evalTerms() const;
+
     void switch_player();
 
     // this is a utility function that returns the positions that can be reached
@@ -108,25 +322,103 @@ public:
     void filter(Position start, const std::vector<Position> &rel, Color pl,
                 bool onlyIfCapture, std::vector<Position> &res) const;
 
-    bool castling_permitted(Piece *, Piece *, int, int);
+    // stores in res the pieces of player pl whose notation is n (see
+    // Piece::notation()) and that attack position to, and returns their number.
+    // There are at most 8 of them. The lookup starts from the target and walks
+    // the knight jumps, king steps or sliding rays backwards, so no move is
+    // generated. For pawns (n == ' ') only the diagonal attackers are
+    // returned, not the pawns that could push to `to`.
+    int attackersTo(Position to, Color pl, char n, Piece *res[8]) const;
+
+    bool castling_permitted(Piece *, Piece *, int, int) const;
 
     void promote_pawn_b(Move *, std::string);
 
+    // undoes promote_pawn_b(m, ...): the new piece is deleted and the pawn is
+    // put back on the board. m is then unperformed as usual.
+    void unpromote_pawn_b(Move *m);
+
     void add_to_achieved_moves(Move *);
 
     Move *get_last_move();
 
 
 private:
-   Piece *addPiece(Piece *);
+   // the state saved by saveState()
+   struct State {
+       // the hash of the position, only set in history_ by saveState(), see
+       // isRepetition()
+       uint64_t key;
+       // CastlingRights
+       uint8_t castling;
+       // the square (8*i + j) a pawn moves to when taking en passant, or -1
+       int8_t en_passant;
+       uint16_t halfmove_clock;
+       // plies played since the start of the game, 2 * (fullmove - 1) + 1 if
+       // Black is to play
+       uint16_t ply;
+   };
+
+   // returns true if the move m of the player to move may leave its king in
+   // check, in_check telling whether it is in check now, so that isLegal()
+   // must be called. Otherwise m is legal: it doesn't move the king, nor a
+   // piece on a line through the king (which could be pinned), nor does it
+   // take en passant (which removes a second piece from a line).
+   bool mayExposeKing(const Move *m, bool in_check) const;
+   // the number of legal moves of the pieces of the player to move other
+   // than the king, see countLegalMoves()
+   int countNonKingMoves(const LegalMasks &masks) const;
+   // the squares the king of the player to move may go to, castling aside
+   Bitboard kingTargets(const LegalMasks &masks) const;
+   // the squares the king of the player to move goes to by castling
+   Bitboard castlingTargets(const LegalMasks &masks) const;
+   // the squares of target the pawn of the player to move on square from may
+   // go to, en passant aside
+   Bitboard pawnTargets(int from, Bitboard target) const;
+   // returns true if the pawn of the player to move on square from can take
+   // en passant, going to square to, without leaving its king in check
+   bool enPassantLegal(int from, int to) const;
+   // creates a piece in pieces_arena_ and adds it to pieces_
+   Piece *addPiece(Position pos, Color c, PieceType type);
+   void setState(const State &s);
    std::vector<Move *> getAllMoves(Color player) const;
    bool isInside(int i, int j) const;
+   void computeHash();
+   // sets bitboards_ and occupancy_ from board_, and the attack maps if
+   // they are maintained
+   void computeBitboards();
+   // computes the attack counts (see attack_counts_) from scratch
+   void computeAttacks(Bitboard counts[2][ATTACK_COUNT_BITS]) const;
+   // adds delta (1 or -1) to the attack counts of player c on squares
+   void addAttacks(Color c, Bitboard squares, int delta);
+   // adds delta to the attack counts of the squares beyond sq on the rays
+   // of the sliders, of both players, that attack sq: they are cut when a
+   // piece is put on sq (-1), and extended when it leaves (1)
+   void updateSliderRays(int sq, int delta);
 
    Piece* board_[8][8];
    Piece *king_[2];
    std::vector<Piece *> pieces_[2];
+   // the memory of the pieces: the 32 of the initial set, allocated first up
+   // to initial_pieces_, then the promoted ones
+   Arena pieces_arena_{PIECES_ARENA_CHUNK_SIZE};
+   Arena::Mark initial_pieces_;
    Color current_player_ = WHITE;
    std::vector<Move *> achieved_moves_;
+   uint64_t hash_ = 0;
+   Bitboard bitboards_[16];
+   Bitboard occupancy_[2];
+   int eval_terms_ = EVAL_ALL_TERMS;
+   bool track_attacks_ = false;
+   // the attack maps, if track_attacks_: the number of attackers of player
+   // c on each square, in bit slices: bit k of the count of square sq is bit
+   // sq of attack_counts_[c][k]. A count is then incremented on a whole set
+   // of squares by a few bitwise operations, as a binary adder does. There
+   // are at most 16 attackers: the first piece in each of the 8 directions,
+   // and 8 knights.
+   Bitboard attack_counts_[2][ATTACK_COUNT_BITS];
+   State state_;
+   std::vector<State> history_;
 };
 
 #endif // BOARD_H_
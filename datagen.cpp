@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "datagen.h"
+#include "match.h"
+#include "move.h"
+#include "piece.h"
+#include "search.h"
+#include "transposition.h"
+
+// the progress is written every REPORT_POSITIONS positions
+static const long REPORT_POSITIONS = 1000;
+
+// splitmix64, the generator of the random plies of the openings
+static uint64_t nextRandom(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void encodePosition(const Board &b, DataRecord &r) {
+    r = DataRecord();
+    int n = 0;
+    for (unsigned int i = 0; i < 8; i++) {
+        for (unsigned int j = 0; j < 8; j++) {
+            Piece *p;
+            if (!b.getPiece({i, j}, &p)) {
+                continue;
+            }
+            r.occupancy |= 1ULL << (8 * i + j);
+            r.pieces[n / 2] |= p->code() << (4 * (n % 2));
+            n++;
+        }
+    }
+    r.flags = ((b.getPlayer() == WHITE) ? 1 : 0) | b.castlingRights() << 1;
+    Position ep;
+    r.en_passant = b.enPassant(&ep) ? ep.second : 8;
+    r.halfmove_clock = std::min(b.halfmoveClock(), 255);
+    r.fullmove_number = std::min(b.fullmoveNumber(), 65535);
+}
+
+std::string decodePosition(const DataRecord &r) {
+    char squares[64] = {0};
+    int n = 0;
+    for (int s = 0; s < 64; s++) {
+        if ((r.occupancy >> s & 1) == 0) {
+            continue;
+        }
+        squares[s] = PIECE_CHAR[(r.pieces[n / 2] >> (4 * (n % 2))) & 15];
+        n++;
+    }
+    std::string fen;
+    for (int i = 7; i >= 0; i--) {
+        int empty = 0;
+        for (int j = 0; j < 8; j++) {
+            char c = squares[8 * i + j];
+            if (c == 0) {
+                empty++;
+                continue;
+            }
+            if (empty > 0) {
+                fen += (char) ('0' + empty);
+                empty = 0;
+            }
+            fen += c;
+        }
+        if (empty > 0) {
+            fen += (char) ('0' + empty);
+        }
+        if (i > 0) {
+            fen += '/';
+        }
+    }
+    bool white = r.flags & 1;
+    fen += white ? " w " : " b ";
+    const char *rights = "KQkq";
+    size_t size = fen.size();
+    for (int k = 0; k < 4; k++) {
+        if (r.flags >> (k + 1) & 1) {
+            fen += rights[k];
+        }
+    }
+    fen += (fen.size() == size) ? "- " : " ";
+    if (r.en_passant < 8) {
+        fen += (char) ('a' + r.en_passant);
+        fen += white ? '6' : '3';
+    } else {
+        fen += '-';
+    }
+    return fen + " " + std::to_string(r.halfmove_clock) + " " +
+           std::to_string(r.fullmove_number);
+}
+
+// the games of a worker are played on its board and search, and written in
+// its shard
+struct DatagenWorker {
+    Board board;
+    Search search;
+    std::unique_ptr<TranspositionTable> tt;
+    std::ofstream shard;
+    std::vector<DataRecord> records;
+};
+
+// plays m on b, the promotions being to a queen as in the search
+static void play(Board &b, Move *m) {
+    bool promotes = m->isPromotion();
+    m->perform(&b);
+    b.switch_player();
+    if (promotes) {
+        b.promote_pawn_b(m, "Q");
+    }
+}
+
+// plays a game on the board of w, seed drawing its opening, and replaces
+// w.records by the records of its quiet positions. Returns false if the game
+// is dropped at the end of its opening.
+static bool playGame(DatagenWorker &w, uint64_t seed, long nodes) {
+    Board &b = w.board;
+    b.reset();
+    w.tt->clear();
+    w.records.clear();
+    for (int ply = 0; ply < DATAGEN_RANDOM_PLIES; ply++) {
+        std::vector<Move *> legal = b.getAllLegalMoves();
+        if (legal.empty()) {
+            return false;
+        }
+        play(b, legal[nextRandom(seed) % legal.size()]);
+        for (auto m : legal) {
+            delete m;
+        }
+    }
+    GameOutcome outcome;
+    for (int ply = DATAGEN_RANDOM_PLIES; ; ply++) {
+        outcome = gameOutcome(b, ply);
+        if (outcome != NOT_OVER) {
+            break;
+        }
+        Color player = b.getPlayer();
+        SearchResult r = w.search.run(b, MAX_SEARCH_DEPTH, nodes);
+        if (ply == DATAGEN_RANDOM_PLIES && std::abs(r.score) > DATAGEN_MAX_OPENING_SCORE) {
+            deletePV(r, NULL);
+            return false;
+        }
+        if (r.score > MATE - 1000) {
+            deletePV(r, NULL);
+            outcome = (player == WHITE) ? WHITE_WINS : BLACK_WINS;
+            break;
+        }
+        Move *m = r.best;
+        if (!m->doesCapture(NULL) && !m->isPromotion() && !b.isInCheck(player)) {
+            DataRecord record;
+            encodePosition(b, record);
+            int score = r.score * 100 / PAWN_SCORE;
+            score = (player == WHITE) ? score : -score;
+            record.score = std::max(-32767, std::min(32767, score));
+            w.records.push_back(record);
+        }
+        play(b, m);
+        deletePV(r, NULL);
+    }
+    uint8_t result = (outcome == WHITE_WINS) ? 2 : (outcome == BLACK_WINS) ? 0 : 1;
+    for (auto &record : w.records) {
+        record.result = result;
+    }
+    return true;
+}
+
+bool generateData(const std::string &output, const DatagenOptions &options,
+                  ThreadPool &pool, std::ostream &log, DatagenSummary *summary) {
+    std::vector<DatagenWorker> workers(pool.size());
+    for (size_t k = 0; k < workers.size(); k++) {
+        DatagenWorker &w = workers[k];
+        w.tt.reset(new TranspositionTable(DATAGEN_TT_MB));
+        w.search.setTable(w.tt.get());
+        w.shard.open(output + "." + std::to_string(k), std::ios::binary | std::ios::trunc);
+        if (!w.shard) {
+            return false;
+        }
+    }
+    *summary = DatagenSummary();
+    std::mutex mutex;
+    std::atomic<long> next_game(0);
+    std::atomic<bool> failed(false);
+    parallelFor(pool, workers.size(), [&](size_t, int worker) {
+        DatagenWorker &w = workers[worker];
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (summary->positions >= options.positions || failed) {
+                    return;
+                }
+            }
+            uint64_t game = next_game++;
+            bool played = playGame(w, options.seed ^ (game * 0xD1B54A32D192ED03ULL),
+                                   options.nodes);
+            if (played && !w.records.empty()) {
+                w.shard.write((const char *) w.records.data(),
+                              w.records.size() * sizeof(DataRecord));
+                w.shard.flush();
+                if (!w.shard) {
+                    failed = true;
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            summary->games++;
+            if (!played) {
+                summary->dropped++;
+                continue;
+            }
+            long before = summary->positions;
+            summary->positions += w.records.size();
+            if (before / REPORT_POSITIONS != summary->positions / REPORT_POSITIONS) {
+                log << summary->positions << " positions, " << summary->games << " games ("
+                    << summary->dropped << " dropped)" << std::endl;
+            }
+        }
+    });
+    return !failed;
+}
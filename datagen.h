@@ -0,0 +1,92 @@
+// This module generates labelled positions to tune the evaluation:
+//
+//   main datagen output positions [threads] [nodes] [seed]
+//
+// The workers of a thread pool play games of the engine against itself, each
+// move being searched to a fixed number of nodes, from openings made of
+// DATAGEN_RANDOM_PLIES random moves from the initial position. The openings
+// that the first search finds unbalanced are dropped. A game ends as in a
+// match (see gameOutcome() in match.h), or when the player to move announces
+// a mate.
+//
+// The quiet positions of a game, those where the player to move is not in
+// check and the best move found neither captures nor promotes, are stored
+// with the score of their search and the result of the game, one DataRecord
+// of 32 bytes each. Worker k appends the records of its games to the shard
+// output.k as each game ends. The shards have no header: they can be
+// concatenated, and shuffled record by record.
+//
+// A game only depends on the seed, its number and the number of nodes, not
+// on the worker that plays it.
+
+#ifndef DATAGEN_H_
+#define DATAGEN_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "board.h"
+#include "threadpool.h"
+
+// the random plies of the openings
+const int DATAGEN_RANDOM_PLIES = 8;
+
+// the nodes searched per move by default
+const long DATAGEN_NODES = 2000;
+
+// the openings whose first search gives a greater score (in absolute value)
+// are dropped
+const int DATAGEN_MAX_OPENING_SCORE = 3 * PAWN_SCORE;
+
+// the size of the transposition table of each worker, in megabytes
+const size_t DATAGEN_TT_MB = 8;
+
+// a position, as stored by a little-endian machine
+struct DataRecord {
+    // the occupied squares, bit 8 * rank + file (a1 is bit 0, h8 bit 63)
+    uint64_t occupancy;
+    // the PieceCode (see piece.h) of each occupied square, in the order of
+    // the bits, two per byte, the first one in the low 4 bits
+    uint8_t pieces[16];
+    // the score of the search in centipawns, from the point of view of White
+    int16_t score;
+    // the result of the game: 0 if Black won, 1 for a draw, 2 if White won
+    uint8_t result;
+    // bit 0: White to play, bits 1 to 4: Board::castlingRights()
+    uint8_t flags;
+    // the file of the en passant square, 8 if none
+    uint8_t en_passant;
+    uint8_t halfmove_clock;
+    uint16_t fullmove_number;
+};
+
+static_assert(sizeof(DataRecord) == 32, "DataRecord must be 32 bytes");
+
+// stores the position of b in r; the score and the result are left to 0
+void encodePosition(const Board &b, DataRecord &r);
+
+// returns the position of r in the Forsyth-Edwards Notation
+std::string decodePosition(const DataRecord &r);
+
+struct DatagenOptions {
+    // the positions to generate: the games being finished, a few more are
+    // written
+    long positions = 0;
+    long nodes = DATAGEN_NODES;
+    uint64_t seed = 1;
+};
+
+struct DatagenSummary {
+    long games = 0;
+    // the games dropped at the end of their opening
+    long dropped = 0;
+    long positions = 0;
+};
+
+// plays games on the workers of pool until options.positions are written in
+// the shards of output, a line with the progress being written on log every
+// 1000 positions. Returns false if a shard can't be written.
+bool generateData(const std::string &output, const DatagenOptions &options,
+                  ThreadPool &pool, std::ostream &log, DatagenSummary *summary);
+
+#endif // DATAGEN_H_
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include "eval.h"
+#include "bitboard.h"
+
+// by PieceType: the centipawns of each safe square a piece can go to beyond
+// the typical number of MOBILITY_BASE
+static const int MOBILITY_WEIGHT[7] = {0, 0, 4, 5, 2, 1, 0};
+static const int MOBILITY_BASE[7] = {0, 0, 4, 6, 7, 13, 0};
+
+// by PieceType: the units of each square around the king a piece attacks
+static const int KING_ATTACK_UNITS[7] = {0, 0, 2, 2, 3, 5, 0};
+
+// the percentage of the units that counts, by number of attackers
+static const int KING_ATTACKERS_SCALE[8] = {0, 0, 50, 75, 88, 94, 97, 99};
+
+// the centipawns of a unit of attack on the king
+const int KING_ATTACK_UNIT_CP = 10;
+
+// the centipawns of each pawn of the shield of the king, on the rank in front
+// of it, and on the next one
+const int SHIELD_CLOSE_CP = 12;
+const int SHIELD_FAR_CP = 6;
+
+// the counts of the terms of a player, summed over its pieces
+struct SideTerms {
+    int mobility = 0;
+    int king_units = 0;
+    int king_attackers = 0;
+};
+
+// adds to t the terms of the pieces of type T of player Us
+template <Color Us, PieceType T>
+static void addPieceTerms(const Board &b, int terms, Bitboard safe, Bitboard king_zone,
+                          SideTerms &t) {
+    Bitboard occupied = b.occupancy();
+    Bitboard pieces = b.pieces(pieceCode(T, Us));
+    while (pieces) {
+        Bitboard a = attacks<T>(popLsb(pieces), occupied);
+        if (terms & EVAL_MOBILITY) {
+            t.mobility += MOBILITY_WEIGHT[T] * (popcount(a & safe) - MOBILITY_BASE[T]);
+        }
+        Bitboard hits = a & king_zone;
+        if ((terms & EVAL_KING_SAFETY) && hits) {
+            t.king_attackers++;
+            t.king_units += KING_ATTACK_UNITS[T] * popcount(hits);
+        }
+    }
+}
+
+// returns the terms of player Us, in centipawns
+template <Color Us>
+static int evaluateSide(const Board &b, int terms) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    constexpr Direction Up = (Us == WHITE) ? NORTH : SOUTH;
+    // the first two ranks of Us
+    constexpr Bitboard Home = (Us == WHITE) ? RANK_1 | RANK_2 : RANK_7 | RANK_8;
+    Bitboard safe = ~b.occupancy(Us) & ~pawnsAttacks(Them, b.pieces(pieceCode(PAWN, Them)));
+    Bitboard their_king = b.pieces(pieceCode(KING, Them));
+    Bitboard king_zone = kingsAttacks(their_king) | their_king;
+    SideTerms t;
+    if (terms & (EVAL_MOBILITY | EVAL_KING_SAFETY)) {
+        addPieceTerms<Us, KNIGHT>(b, terms, safe, king_zone, t);
+        addPieceTerms<Us, BISHOP>(b, terms, safe, king_zone, t);
+        addPieceTerms<Us, ROOK>(b, terms, safe, king_zone, t);
+        addPieceTerms<Us, QUEEN>(b, terms, safe, king_zone, t);
+    }
+    int res = t.mobility + t.king_units * KING_ATTACK_UNIT_CP *
+              KING_ATTACKERS_SCALE[std::min(t.king_attackers, 7)] / 100;
+    Bitboard king = b.pieces(pieceCode(KING, Us));
+    if ((terms & EVAL_PAWN_SHIELD) && (king & Home)) {
+        Bitboard pawns = b.pieces(pieceCode(PAWN, Us));
+        Bitboard close = shift<Up>(king | shift<EAST>(king) | shift<WEST>(king));
+        Bitboard far = shift<Up>(close);
+        res += SHIELD_CLOSE_CP * popcount(pawns & close) + SHIELD_FAR_CP * popcount(pawns & far);
+    }
+    return res;
+}
+
+int evaluateTerms(const Board &b, int terms) {
+    if (terms == 0) {
+        return 0;
+    }
+    int cp = evaluateSide<WHITE>(b, terms) - evaluateSide<BLACK>(b, terms);
+    return cp * PAWN_SCORE / EVAL_PAWN_CP;
+}
@@ -0,0 +1,29 @@
+// The terms of the evaluation computed on the bitboards of the Board (see
+// bitboard.h), that Board::evaluate() adds to the material and the placement
+// of the pieces. Each one is only computed if it is in the EvalTerms of the
+// board (see Board::setEvalTerms()), to weigh its cost against its strength
+// (see microbench.cpp and match.h):
+//  . EVAL_MOBILITY: the squares each knight, bishop, rook and queen can go
+//    to, those attacked by an enemy pawn excepted, compared with a typical
+//    number for its type
+//  . EVAL_KING_SAFETY: the squares around the enemy king attacked by each
+//    knight, bishop, rook and queen, in units weighted by the type of the
+//    attacker, scaled by the number of attackers: a lone attacker is harmless
+//  . EVAL_PAWN_SHIELD: the pawns in front of a king that stands on one of
+//    its first two ranks, on its file and the files next to it
+// The terms are computed in centipawns and converted, once summed, to the
+// units of Board::evaluate() (PAWN_SCORE per pawn).
+
+#ifndef EVAL_H_
+#define EVAL_H_
+
+#include "board.h"
+
+// the centipawns of a pawn, the unit of the terms
+const int EVAL_PAWN_CP = 100;
+
+// returns the sum of the terms of b in terms (EvalTerms ored), from the
+// point of view of White, in the units of Board::evaluate()
+int evaluateTerms(const Board &b, int terms);
+
+#endif // EVAL_H_
@@ -0,0 +1,30 @@
+#include "evalcache.h"
+
+EvalCache::EvalCache(size_t size_kb) {
+    size_t n = 1;
+    while (2 * n * sizeof(EvalCacheEntry) <= size_kb * 1024) {
+        n *= 2;
+    }
+    if (size_kb > 0) {
+        entries_.resize(n);
+        mask_ = n - 1;
+    }
+    clear();
+}
+
+void EvalCache::newSearch(int terms) {
+    if (terms != terms_) {
+        clear();
+        terms_ = terms;
+    }
+}
+
+void EvalCache::clear() {
+    for (auto &e : entries_) {
+        e = EvalCacheEntry();
+    }
+}
+
+size_t EvalCache::size() const {
+    return entries_.size();
+}
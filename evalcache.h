@@ -0,0 +1,81 @@
+// This module implements the evaluation cache of the search: a small hash
+// table, indexed by the Zobrist key of the positions (see Board::hash()),
+// that remembers their static evaluation (see Board::evaluate()). The same
+// leaves are evaluated again and again, by the quiescence search and through
+// transpositions, and the terms of eval.h make an evaluation much dearer
+// than a lookup.
+// see https://www.chessprogramming.org/Evaluation_Hash_Table
+//
+// The table is direct-mapped: a position always replaces the one in its
+// slot. An entry only keeps the upper 32 bits of the key, the lower ones
+// giving the slot, so two positions are mistaken for each other about once
+// in 2^32 lookups, as an empty entry is for a position whose key has its
+// upper bits 0. Each Search has its own cache (see Search::setEvalCacheSize()),
+// a thread never shares it.
+
+#ifndef EVALCACHE_H_
+#define EVALCACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// the size of the cache of a Search until set otherwise, in kilobytes
+const size_t EVAL_CACHE_KB = 256;
+
+struct EvalCacheEntry {
+    // the upper 32 bits of the key
+    uint32_t key;
+    // the score of Board::evaluate()
+    int32_t score;
+};
+
+static_assert(sizeof(EvalCacheEntry) == 8, "EvalCacheEntry must be 8 bytes");
+
+class EvalCache {
+public:
+    // allocates about size_kb kilobytes (rounded down to a power of 2
+    // entries), 0 for no cache: nothing is then ever found
+    explicit EvalCache(size_t size_kb = EVAL_CACHE_KB);
+
+    // returns true and sets *score to the score of the position key if it is
+    // stored
+    bool probe(uint64_t key, int *score) const {
+        if (entries_.empty()) {
+            return false;
+        }
+        const EvalCacheEntry &e = entries_[key & mask_];
+        if (e.key != (uint32_t) (key >> 32)) {
+            return false;
+        }
+        *score = e.score;
+        return true;
+    }
+
+    void store(uint64_t key, int score) {
+        if (entries_.empty()) {
+            return;
+        }
+        EvalCacheEntry &e = entries_[key & mask_];
+        e.key = (uint32_t) (key >> 32);
+        e.score = score;
+    }
+
+    // called at the start of each search with the terms of the evaluation
+    // (see Board::evalTerms()): the scores of other terms are forgotten
+    void newSearch(int terms);
+
+    // forgets all the positions
+    void clear();
+
+    // number of entries
+    size_t size() const;
+
+private:
+    std::vector<EvalCacheEntry> entries_;
+    size_t mask_ = 0;
+    // the terms of the stored scores
+    int terms_ = -1;
+};
+
+#endif // EVALCACHE_H_
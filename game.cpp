@@ -9,9 +9,10 @@
 #include "board.h"
 #include "global.h"
 #include "piece.h"
-#include "concretepieces.h"
 #include "move.h"
 #include "tree.h"
+#include "notation.h"
+#include "search.h"
 
 Game::Game() { }
 
@@ -55,7 +56,23 @@ std::vector<Move *> Game::getAllLegalMoves() {
     return board_.getAllLegalMoves();
 }
 
-Move *greedy_move(Board b) {
+bool Game::hasLegalMove() {
+    return board_.hasLegalMove();
+}
+
+Move *Game::parseMove(const std::string &san, char *promotion) {
+    return ::parseMove(board_, san, promotion);
+}
+
+std::string Game::toSAN(Move *m, char promotion) {
+    return ::toSAN(board_, m, promotion);
+}
+
+size_t Game::writeSANList(const std::vector<Move *> &moves, char *buf, size_t size) {
+    return ::writeSANList(board_, moves, buf, size);
+}
+
+Move *greedy_move(Board &b) {
     """
     Returns the moves with the most favorables heuristic value
     """
@@ -86,80 +103,25 @@ Move *greedy_move(Board b) {
     }
 }
 
-int minimax(Board b, int depth, int color) {
-    """
-    returns the best heuristic value by maximizing the H value in this turn and
-    minimizing it in the opponent's turn
-    """
-    std::vector<Move *> moves = b.getAllLegalMoves();
-    if (depth == 0 || moves.size() == 1) {
-      return b.heuristic();
-    } else if (color) {
-      int best_value = MINF;
-      for (auto m : moves) {
-        m->perform(&b);
-        int v = minimax(b, depth-1, 1-color);
-        m->unPerform(&b);
-        best_value = (v > best_value)? v : best_value;
-      }
-    } else if (!color) {
-      int best_value = INF;
-      for (auto m : moves) {
-        m->perform(&b);
-        int v = minimax(b, depth-1, 1-color);
-        m->unPerform(&b);
-        best_value = (v < best_value)? v : best_value;
-      }
-    }
-    return 0;
-}
-
-Move *minimax_move(Board b, int strength) {
-    """
-    returns the move with the best minimax() value by performing all of the moves
-    """
-    std::vector<Move *> moves = b.getAllLegalMoves();
-    int color = (int) b.getPlayer();
-    moves[0]->perform(&b);
-    int min_ = b.heuristic();
-    moves[0]->unPerform(&b);
-    int max_ = min_;
-    int min_idx = 0;
-    int max_idx = 0;
-    int current;
-    for (unsigned int i = 1; i < moves.size(); i++) {
-      moves[i]->perform(&b);
-      current = minimax(b, strength-1, 1-color);
-      if (current < min_) {
-        min_ = current;
-        min_idx = i;
-      } else if (current > max_) {
-        max_ = current;
-        max_idx = i;
-      }
-      moves[i]->unPerform(&b);
-    }
-    if (color) {
-      return moves[max_idx];
-    } else {
-      return moves[min_idx];
-    }
-}
-
-
 Move *Game::computerSuggestion(int strength) {
-    std::vector<Move *> moves = board_.getAllLegalMoves();
     switch (strength) {
       case 0:
         {
+        std::vector<Move *> moves = board_.getAllLegalMoves();
         int rand_idx = rand() % moves.size();
         return moves[rand_idx];
         }
       case 1:
         return greedy_move(board_);
       default:
-        return minimax_move(board_, strength);
-        break;
+        {
+        // the strength is the depth of the search
+        Search search;
+        SearchResult r = search.run(board_, strength);
+        Move *best = r.best;
+        deletePV(r, best);
+        return best;
+        }
     }
     return NULL;
 }
@@ -175,3 +137,31 @@ Tree *Game::getOpenings() {
 void Game::setOpenings(Tree *t) {
     openings_ = t;
 }
+
+Tree *Game::newOpenings() {
+    openings_ = NULL;
+    openings_arena_.release();
+    return openings_arena_.make<Tree>(openings_arena_);
+}
+
+PositionIndex *Game::getPositionIndex() {
+    return position_index_;
+}
+
+void Game::setPositionIndex(PositionIndex *index) {
+    position_index_ = index;
+}
+
+uint64_t Game::hash() {
+    return board_.hash();
+}
+
+bool Game::setPosition(const std::string &fen) {
+    openings_ = NULL;
+    openings_arena_.release();
+    return board_.fromFEN(fen);
+}
+
+std::string Game::toFEN() {
+    return board_.toFEN();
+}
@@ -8,6 +8,7 @@
 #include "move.h"
 #include "board.h"
 #include "tree.h"
+#include "posindex.h"
 
 // This class defines a game as seen by the 'main' module. It has the following
 // roles:
@@ -31,6 +32,19 @@ public:
 
     std::vector<Move *> getAllLegalMoves();
 
+    // returns true if the player to move has a legal move, see
+    // Board::hasLegalMove()
+    bool hasLegalMove();
+
+    // returns the legal move written as text in san (see notation.h) or NULL
+    Move *parseMove(const std::string &san, char *promotion);
+
+    // returns the SAN of the legal move m, see notation.h
+    std::string toSAN(Move *m, char promotion);
+
+    // writes the SAN of the legal moves in buf, see writeSANList()
+    size_t writeSANList(const std::vector<Move *> &moves, char *buf, size_t size);
+
     Move *computerSuggestion(int strength);
 
     void play(Move *);
@@ -43,11 +57,34 @@ public:
 
     void setOpenings(Tree *);
 
+    // drops the openings (see getOpenings()) and returns an empty tree, to be
+    // filled and given to setOpenings(). Its nodes are freed with those of
+    // the previous openings, by the next call.
+    Tree *newOpenings();
+
+    PositionIndex *getPositionIndex();
+
+    void setPositionIndex(PositionIndex *);
+
+    // returns the Zobrist key of the current position, see Board::hash()
+    uint64_t hash();
+
+    // starts again from the position fen, see Board::fromFEN(). The openings
+    // are dropped, they start from the initial position.
+    // returns false (and starts from the initial position) if fen is not valid.
+    bool setPosition(const std::string &fen);
+
+    // returns the FEN of the current position, see Board::toFEN()
+    std::string toFEN();
+
 
 private:
 
     Board board_;
     Tree *openings_ = NULL;
+    // the memory of the nodes of the openings
+    Arena openings_arena_;
+    PositionIndex *position_index_ = NULL;
 };
 
 #endif // GAME_H_
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "gamestore.h"
+#include "arena.h"
+#include "bitboard.h"
+#include "notation.h"
+#include "piece.h"
+
+static const char PROMOTIONS[] = "QRBN";
+
+int storeIndex(const Board &b, int from, int to) {
+    Bitboard own = b.occupancy(b.getPlayer());
+    if (!(own & squareBit(from))) {
+        return -1;
+    }
+    LegalMasks masks = b.legalMasks();
+    Bitboard tos = b.legalTargets(from, masks);
+    if (!(tos & squareBit(to))) {
+        return -1;
+    }
+    // the moves of the pieces on the lower squares come first
+    int k = popcount(tos & (squareBit(to) - 1));
+    for (Bitboard before = own & (squareBit(from) - 1); before;) {
+        k += popcount(b.legalTargets(popLsb(before), masks));
+    }
+    return k;
+}
+
+bool storeMove(const Board &b, int k, int *from, int *to) {
+    LegalMasks masks = b.legalMasks();
+    for (Bitboard own = b.occupancy(b.getPlayer()); own;) {
+        int sq = popLsb(own);
+        Bitboard tos = b.legalTargets(sq, masks);
+        int n = popcount(tos);
+        if (k < n) {
+            for (; k > 0; k--) {
+                tos &= tos - 1;
+            }
+            *from = sq;
+            *to = lsb(tos);
+            return true;
+        }
+        k -= n;
+    }
+    return false;
+}
+
+// creates in arena the legal move of b from square from to square to
+static Move *makeMove(const Board &b, Arena &arena, int from, int to) {
+    Piece *moved = b.pieceAt(from);
+    Piece *captured = b.pieceAt(to);
+    Position f = squarePosition(from);
+    Position t = squarePosition(to);
+    if (moved->type() == KING && (to == from + 2 || to == from - 2)) {
+        return arena.make<Castling>(moved, b.pieceAt((to > from) ? from + 3 : from - 4));
+    }
+    if (moved->type() == PAWN && captured == NULL && (to - from) % 8 != 0) {
+        // the pawn taken en passant is behind the square the pawn goes to
+        Piece *taken = b.pieceAt((b.getPlayer() == WHITE) ? to - 8 : to + 8);
+        return arena.make<EnPassant>(f, t, moved, taken);
+    }
+    if (captured != NULL) {
+        return arena.make<BasicMoveWithCapture>(f, t, moved, captured);
+    }
+    return arena.make<BasicMove>(f, t, moved);
+}
+
+// plays m on b, with the promotion to the piece letter promotion if it is
+// a promotion
+static void playStored(Board &b, Move *m, char promotion) {
+    bool promotes = m->isPromotion();
+    m->perform(&b);
+    b.switch_player();
+    if (promotes) {
+        b.promote_pawn_b(m, std::string(1, promotion));
+    }
+}
+
+bool encodeGame(Board &b, const PgnGame &g, std::string &bytes) {
+    b.reset();
+    bytes.clear();
+    if (!g.tag("FEN").empty()) {
+        // the store only holds games played from the initial position
+        return false;
+    }
+    for (const auto &san : g.moves) {
+        char promotion;
+        Move *m = parseMove(b, san, &promotion);
+        if (m == NULL || bytes.size() >= UINT16_MAX) {
+            delete m;
+            return false;
+        }
+        bytes += (char) storeIndex(b, square(m->getFrom()), square(m->getTo()));
+        if (m->isPromotion()) {
+            bytes += (char) (strchr(PROMOTIONS, promotion) - PROMOTIONS);
+        }
+        playStored(b, m, promotion);
+        delete m;
+    }
+    return true;
+}
+
+// returns the date yyyy.mm.dd as the integer yyyymmdd, the unknown parts
+// ("??") being 0
+static uint32_t parseDate(const std::string &date) {
+    uint32_t parts[3] = {0, 0, 0};
+    int part = 0;
+    for (size_t i = 0; i < date.size() && part < 3; i++) {
+        if (date[i] == '.') {
+            part++;
+        } else if (isdigit(date[i])) {
+            parts[part] = parts[part] * 10 + (date[i] - '0');
+        }
+    }
+    return parts[0] * 10000 + parts[1] * 100 + parts[2];
+}
+
+GameResult parseResult(const std::string &result) {
+    if (result == "1-0") {
+        return RESULT_WHITE;
+    } else if (result == "0-1") {
+        return RESULT_BLACK;
+    } else if (result == "1/2-1/2") {
+        return RESULT_DRAW;
+    }
+    return RESULT_UNKNOWN;
+}
+
+bool writeGameStore(const std::string &filename, const std::vector<PgnGame> &games,
+                    ThreadPool &pool, std::vector<size_t> &rejected) {
+    // the games are encoded in parallel
+    std::vector<std::string> bytes(games.size());
+    std::vector<char> valid(games.size());
+    std::vector<Board> boards(pool.size());
+    parallelFor(pool, games.size(), [&](size_t i, int worker) {
+        valid[i] = encodeGame(boards[worker], games[i], bytes[i]);
+    });
+
+    std::map<std::string, uint32_t> ids;
+    std::vector<std::string> names;
+    auto playerId = [&](const std::string &name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t id = names.size();
+        ids[name] = id;
+        names.push_back(name);
+        return id;
+    };
+
+    std::vector<GameRecord> index;
+    uint64_t count = games.size();
+    for (size_t i = 0; i < games.size(); i++) {
+        count -= !valid[i];
+    }
+    uint64_t offset = sizeof(GameStoreHeader) + count * sizeof(GameRecord);
+    for (size_t i = 0; i < games.size(); i++) {
+        if (!valid[i]) {
+            rejected.push_back(i);
+            continue;
+        }
+        GameRecord r;
+        memset(&r, 0, sizeof(r));
+        r.offset = offset;
+        r.white = playerId(games[i].tag("White"));
+        r.black = playerId(games[i].tag("Black"));
+        r.date = parseDate(games[i].tag("Date"));
+        r.plies = games[i].moves.size();
+        r.result = parseResult(games[i].result);
+        std::string eco = games[i].tag("ECO");
+        memcpy(r.eco, eco.c_str(), std::min(eco.size(), sizeof(r.eco)));
+        index.push_back(r);
+        offset += bytes[i].size();
+    }
+
+    GameStoreHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, GAMESTORE_MAGIC, sizeof(h.magic));
+    h.version = GAMESTORE_VERSION;
+    h.game_count = count;
+    h.index_offset = sizeof(GameStoreHeader);
+    // the player offsets are aligned on 4 bytes
+    uint64_t padding = (4 - offset % 4) % 4;
+    h.players_offset = offset + padding;
+    h.player_count = names.size();
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    file.write((const char *) &h, sizeof(h));
+    file.write((const char *) index.data(), index.size() * sizeof(GameRecord));
+    for (size_t i = 0; i < games.size(); i++) {
+        if (valid[i]) {
+            file.write(bytes[i].data(), bytes[i].size());
+        }
+    }
+    file.write("\0\0\0", padding);
+    uint32_t name_offset = names.size() * sizeof(uint32_t);
+    for (const auto &name : names) {
+        file.write((const char *) &name_offset, sizeof(name_offset));
+        name_offset += name.size() + 1;
+    }
+    for (const auto &name : names) {
+        file.write(name.c_str(), name.size() + 1);
+    }
+    return (bool) file;
+}
+
+GameStore::GameStore() { }
+
+GameStore::~GameStore() {
+    close();
+}
+
+bool GameStore::open(const std::string &filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(GameStoreHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    data_ = (const uint8_t *) data;
+    length_ = st.st_size;
+    header_ = (const GameStoreHeader *) data_;
+    if (memcmp(header_->magic, GAMESTORE_MAGIC, sizeof(GAMESTORE_MAGIC)) != 0 ||
+        header_->version != GAMESTORE_VERSION ||
+        header_->index_offset > length_ ||
+        header_->game_count > (length_ - header_->index_offset) / sizeof(GameRecord) ||
+        header_->players_offset > length_ ||
+        header_->player_count > (length_ - header_->players_offset) / sizeof(uint32_t)) {
+        close();
+        return false;
+    }
+    index_ = (const GameRecord *) (data_ + header_->index_offset);
+    players_ = (const uint32_t *) (data_ + header_->players_offset);
+    // each name must end before the end of the file
+    for (uint64_t id = 0; id < header_->player_count; id++) {
+        uint64_t offset = header_->players_offset + players_[id];
+        if (offset >= length_ || memchr(data_ + offset, '\0', length_ - offset) == NULL) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void GameStore::close() {
+    if (data_ != NULL) {
+        munmap((void *) data_, length_);
+    }
+    data_ = NULL;
+    length_ = 0;
+    header_ = NULL;
+    index_ = NULL;
+    players_ = NULL;
+}
+
+size_t GameStore::size() const {
+    return (header_ == NULL) ? 0 : header_->game_count;
+}
+
+const GameRecord &GameStore::record(size_t n) const {
+    return index_[n];
+}
+
+const char *GameStore::player(uint32_t id) const {
+    if (header_ == NULL || id >= header_->player_count ||
+        header_->players_offset + players_[id] >= length_) {
+        return "";
+    }
+    return (const char *) players_ + players_[id];
+}
+
+const uint8_t *GameStore::moves(size_t n) const {
+    return data_ + index_[n].offset;
+}
+
+bool GameStore::replay(size_t n, Board &b, const MoveVisitor &visit) const {
+    b.reset();
+    const uint8_t *p = moves(n);
+    const uint8_t *end = data_ + length_;
+    Arena &arena = threadArena();
+    for (int ply = 0; ply < index_[n].plies; ply++) {
+        int from;
+        int to;
+        if (p >= end || !storeMove(b, *p++, &from, &to)) {
+            return false;
+        }
+        // the move is only needed while it is played
+        ArenaScope scope(arena);
+        Move *m = makeMove(b, arena, from, to);
+        char promotion = ' ';
+        if (m->isPromotion()) {
+            if (p >= end || *p >= sizeof(PROMOTIONS) - 1) {
+                return false;
+            }
+            promotion = PROMOTIONS[*p++];
+        }
+        if (visit) {
+            visit(b, m, promotion);
+        }
+        playStored(b, m, promotion);
+    }
+    return true;
+}
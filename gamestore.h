@@ -0,0 +1,132 @@
+// This module defines a compact binary format to store many games, so that
+// they can be replayed without parsing PGN text again.
+//
+// A file is made of:
+//  . a header (GameStoreHeader)
+//  . the index: one fixed-size GameRecord per game, so that game n is found
+//    directly at index_offset + n * sizeof(GameRecord)
+//  . the moves of all the games. A move is stored on one byte, its index in
+//    the legal moves of the position ordered by starting then final square
+//    (see storeIndex()). A pawn promotion is followed by a second byte, the
+//    index of the new piece in "QRBN".
+//  . the names of the players: player_count offsets (uint32_t, from
+//    players_offset), followed by the '\0'-terminated names.
+//
+// The file is read through mmap(), nothing is copied or parsed when it is
+// opened.
+
+#ifndef GAMESTORE_H_
+#define GAMESTORE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "move.h"
+#include "pgn.h"
+#include "replay.h"
+#include "threadpool.h"
+
+const char GAMESTORE_MAGIC[4] = {'C', 'G', 'S', 'T'};
+// version 2: the en passant captures are legal moves, and castling needs the
+// castling right, which changes the order of the legal moves
+const uint32_t GAMESTORE_VERSION = 2;
+
+struct GameStoreHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t game_count;
+    uint64_t index_offset;
+    uint64_t players_offset;
+    uint64_t player_count;
+};
+
+enum GameResult { RESULT_UNKNOWN = 0, RESULT_WHITE = 1, RESULT_BLACK = 2, RESULT_DRAW = 3 };
+
+// returns the GameResult of a PGN result, e.g. "1-0"
+GameResult parseResult(const std::string &result);
+
+struct GameRecord {
+    // position of the first move of the game in the file
+    uint64_t offset;
+    // indices of the players' names
+    uint32_t white;
+    uint32_t black;
+    // yyyymmdd, with 0 for the unknown parts, e.g. 19930000 for "1993.??.??"
+    uint32_t date;
+    // number of moves, the promotions have one more byte each
+    uint16_t plies;
+    // a GameResult
+    uint8_t result;
+    // e.g. "C02", or "\0\0\0" if unknown
+    char eco[3];
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(GameRecord) == 32, "GameRecord must be 32 bytes");
+
+// returns the index of the move of b from square from to square to (see
+// bitboard.h) among the legal moves ordered by starting then final square, a
+// castling being a move of the king, or -1 if it is not legal. The index is
+// counted on the squares each piece may go to (see Board::legalTargets()),
+// without creating the moves.
+int storeIndex(const Board &b, int from, int to);
+
+// the reverse of storeIndex(): stores in *from and *to the squares of the
+// move of index k of b, and returns false if there is none
+bool storeMove(const Board &b, int k, int *from, int *to);
+
+// converts a game to its stored moves, by replaying it on b. Returns false
+// if the game contains an illegal move or doesn't start from the initial
+// position (FEN tag).
+bool encodeGame(Board &b, const PgnGame &g, std::string &bytes);
+
+// writes games in the game store filename, encoding them on the workers of
+// pool. The games that contain an illegal move are not stored; their
+// indices in games are push_back'ed in rejected.
+// returns false if the file can't be written.
+bool writeGameStore(const std::string &filename, const std::vector<PgnGame> &games,
+                    ThreadPool &pool, std::vector<size_t> &rejected);
+
+// A game store opened for reading.
+class GameStore {
+public:
+    GameStore();
+
+    ~GameStore();
+
+    // maps the file filename in memory. returns false if it is not a valid
+    // game store: the index, the player offsets and the '\0'-terminated names
+    // must be inside the file.
+    bool open(const std::string &filename);
+
+    void close();
+
+    // number of games
+    size_t size() const;
+
+    const GameRecord &record(size_t n) const;
+
+    // the name of player id, "" if there is no such player
+    const char *player(uint32_t id) const;
+
+    // the stored moves of game n, see the format above
+    const uint8_t *moves(size_t n) const;
+
+    // replays game n on b from the initial position, calling visit (if not
+    // empty) before each move. The squares of each move are found with
+    // storeMove(), and the move is made in the arena of the thread (see
+    // threadArena()): it is only valid during the call of visit. Returns
+    // false if the stored moves are corrupt.
+    bool replay(size_t n, Board &b, const MoveVisitor &visit) const;
+
+private:
+    const uint8_t *data_ = NULL;
+    size_t length_ = 0;
+    const GameStoreHeader *header_ = NULL;
+    const GameRecord *index_ = NULL;
+    const uint32_t *players_ = NULL;
+};
+
+#endif // GAMESTORE_H_
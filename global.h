@@ -1,13 +1,49 @@
 #ifndef GLOBAL_H_
 #define GLOBAL_H_
 
+#include <cstdint>
 #include <utility>
 #include <string>
 #include <limits>
+#include <memory_resource>
+#include <vector>
 
 // We rely on the property WHITE == true
 enum Color { WHITE = 1, BLACK = 0 };
 
+// The types of the pieces. A piece is designated by its type and color in a
+// 4-bit PieceCode: its type, plus PIECE_BLACK for the black pieces. The
+// tables of piece.h are indexed by the codes.
+enum PieceType { PAWN = 1, KNIGHT = 2, BISHOP = 3, ROOK = 4, QUEEN = 5, KING = 6 };
+
+typedef uint8_t PieceCode;
+
+const PieceCode NO_PIECE = 0;
+const PieceCode PIECE_BLACK = 8;
+
+constexpr PieceCode pieceCode(PieceType t, Color c) {
+    return (c == WHITE) ? t : t | PIECE_BLACK;
+}
+
+constexpr PieceType pieceType(PieceCode code) {
+    return PieceType(code & 7);
+}
+
+constexpr Color pieceColor(PieceCode code) {
+    return (code & PIECE_BLACK) ? BLACK : WHITE;
+}
+
+// the kinds of moves to generate (see movegen.h): CAPTURES are the moves
+// that take a piece, en passant included, and the promotions; QUIETS the
+// others; EVASIONS the moves that may get the player to move out of check.
+enum GenType { CAPTURES, QUIETS, EVASIONS, ALL };
+
+class Move;
+
+// the moves filled by the generators (see movegen.h), in the memory of an
+// Arena when they only live during a call (see arena.h)
+typedef std::pmr::vector<Move *> MoveList;
+
 // A position is of the form {i,j} with i,j ∈ 0..7  
 // In chess notation {0,0} = A1, {7,7} = G8 
 typedef std::pair<unsigned int, unsigned int> Position;
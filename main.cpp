@@ -2,6 +2,39 @@
 // instanciate a Game object and then runs a simple REPL
 // (read-eval-print-loop). Most commands are evaluted by calling a
 // corresponding method on the Game object.
+//
+// The program can also run without the REPL:
+//   main replay file.pgn [threads]   checks that all the games of file.pgn are
+//                                    legal, see replay.h
+//   main import file.pgn file.gst [threads]
+//                                    converts file.pgn to a game store, see
+//                                    gamestore.h
+//   main storereplay file.gst [n]    replays all the games of the game store,
+//                                    or prints game n
+//   main index input out.idx [threads] [memory_mb]
+//                                    builds the position index of the games of
+//                                    input, a PGN file or a game store, see
+//                                    posindex.h
+//   main perft depth [threads] [fen] counts the leaves of the tree of legal
+//                                    moves from the position fen (the initial
+//                                    one by default), see perft.h
+//   main analyze file [depth] [threads]
+//                                    analyses the positions of file to depth
+//                                    plies (4 by default) unless the file
+//                                    sets other limits, see analysis.h
+//   main bench [depth] [file.trc]    searches the bench positions, see bench.h,
+//                                    and records the trace in file.trc if the
+//                                    program is built with TRACE=1, see trace.h
+//   main match configA configB openings [games] [threads] [elo0] [elo1]
+//                                    plays a match between two configurations
+//                                    of the engine from the positions of
+//                                    openings, see match.h
+//   main datagen output positions [threads] [nodes] [seed]
+//                                    plays games of the engine against itself
+//                                    and stores their positions with their
+//                                    score and result, see datagen.h
+//   main --uci                       speaks the UCI protocol on the standard
+//                                    input and output, see uci.h
 
 #include <iostream>
 #include <fstream>
@@ -9,63 +42,39 @@
 #include <cassert>
 #include <string>
 #include <map>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
 #include "game.h"
 #include "move.h"
 #include "piece.h"
 #include "tree.h"
+#include "notation.h"
+#include "pgn.h"
+#include "replay.h"
+#include "gamestore.h"
+#include "posindex.h"
+#include "bench.h"
+#include "searchstats.h"
+#include "trace.h"
+#include "threadpool.h"
+#include "uci.h"
+#include "match.h"
+#include "datagen.h"
+#include "perft.h"
+#include "analysis.h"
+#include <iomanip>
 
 bool isFinished(Game &g) {
-    return g.getAllLegalMoves().size() == 0;
-}
-
-std::vector<int> is_repetetive(std::vector<std::string> moves_str) {
-    std::vector<int> rep_idx;
-    for (int i = 0; i < (int) moves_str.size(); i++) {
-      for (int j = i+1; j < (int) moves_str.size(); j++) {
-        if (moves_str[i] == moves_str[j]) {
-          rep_idx.push_back(i);
-          rep_idx.push_back(j);
-        }
-      }
-    }
-    return rep_idx;
-}
-
-std::vector<std::string> AlgebraicNotation(std::vector<Move *> moves) {
-    """
-    returns a vector of the Algebraic Notation of all the moves in the vector given
-    as parameter
-    """
-    std::vector<std::string> moves_str;
-    for (auto m : moves) {
-      moves_str.push_back(m->toAlgebraicNotation(3));
-    }
-    std::vector<int> rep_idx = is_repetetive(moves_str);
-    int i_AlgebraicNotation = 2;
-    while (rep_idx.size() != 0) {
-      for (auto idx : rep_idx) {
-        moves_str[idx] = moves[idx]->toAlgebraicNotation(i_AlgebraicNotation);
-      }
-      rep_idx.clear();
-      rep_idx = is_repetetive(moves_str);
-      i_AlgebraicNotation--;
-    }
-    return moves_str;
+    return !g.hasLegalMove();
 }
 
 // We need to parse a line, construct a Move, and make sure
 // the move is valid in the current Game.
-// What we do instead is to get all the valid moves, and see
-// if line is equal to the string representation of one of these moves.
-Move *parseAndValidate(Game &g, const std::string &line) {
-    std::vector<Move *> moves = g.getAllLegalMoves();
-    std::vector<std::string> moves_str = AlgebraicNotation(moves);
-    for (int i = 0; i < (int) moves_str.size(); i++) {
-      if (line == moves_str[i]) {
-        return moves[i];
-      }
-    }
-    return NULL;
+// The line is decoded directly (see notation.h), the promotion letter, if
+// any, is stored in *promotion.
+Move *parseAndValidate(Game &g, const std::string &line, char *promotion) {
+    return g.parseMove(line, promotion);
 }
 
 // Transforms a string s into a vector of words (substrings not containing
@@ -89,13 +98,14 @@ void process_openings(Game &g, std::string filename) {
       getline(file, line);
       int Nb_openings = std::stoi(line);
       std::vector<Move *> moves;
-      Tree *t = new Tree();
+      Tree *t = g.newOpenings();
       for (int i = 0; i < Nb_openings; i++) {
           getline(file, line);
           tokenize(line, moves_str);
           int Nb_moves = std::stoi(moves_str[0]);
           for (int j = 1; j <= Nb_moves; j++) {
-              Move *move = parseAndValidate(g, moves_str[j]);
+              char promotion;
+              Move *move = parseAndValidate(g, moves_str[j], &promotion);
               moves.push_back(move);
               if (move == NULL) {
                   std::cout << "The sequence of moves in the file is unvalid, try '?' for list of moves or 'help'" << std::endl;
@@ -172,11 +182,101 @@ void computerPlay(Game &g, int strength) {
     // should not be null as there is always something to play if the game is not
     // finished
     assert(m != NULL);
+    bool promotes = m->isPromotion();
     g.play(m);
+    if (promotes) {
+      g.promote_pawn(m, "Q");
+    }
     std::cout << "Computer played " << m->toBasicNotation() << std::endl;
     g.display();
 }
 
+// Prints the moves played from the current position in the games of the
+// position index, with their number of games, results and score for the
+// current player.
+void explore(Game &g) {
+    PositionIndex *index = g.getPositionIndex();
+    if (index == NULL) {
+        std::cout << "No position index, try 'explore file.idx'" << std::endl;
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MoveStats> stats;
+    index->explore(g.hash(), stats);
+    std::vector<Move *> legal = g.getAllLegalMoves();
+    uint32_t total = 0;
+    std::cout << "move      games  white  draws  black  score" << std::endl;
+    for (const auto &st : stats) {
+        total += st.games;
+        // the move is found among the legal ones, its code has no promotion
+        Move *m = NULL;
+        for (auto lm : legal) {
+            if (encodeMove(lm, ' ') == (st.move & 0xFFF)) {
+                m = lm;
+            }
+        }
+        std::string san = "?";
+        double score = 0;
+        uint32_t known = st.white + st.draws + st.black;
+        if (m != NULL) {
+            san = g.toSAN(m, m->isPromotion() ? "QRBN"[st.move >> 12] : ' ');
+            uint32_t wins = (m->getMoved()->getColor() == WHITE) ? st.white : st.black;
+            score = (known == 0) ? 0 : 100.0 * (wins + 0.5 * st.draws) / known;
+        }
+        std::cout << std::left << std::setw(8) << san << std::right
+                  << std::setw(7) << st.games << std::setw(7) << st.white
+                  << std::setw(7) << st.draws << std::setw(7) << st.black
+                  << std::setw(6) << std::fixed << std::setprecision(1) << score
+                  << "%" << std::endl;
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << total << " games in " << std::setprecision(3) << ms << " ms"
+              << std::defaultfloat << std::endl;
+}
+
+// the trace of the searches, see the trace command
+TraceWriter trace;
+
+// Starts tracing the searches in filename, or stops if filename is "off".
+void traceCommand(const std::string &filename) {
+#ifdef SEARCH_TRACE
+    setThreadTrace(NULL);
+    if (trace.isOpen()) {
+        uint64_t records = trace.size();
+        trace.close();
+        std::cout << records << " nodes traced" << std::endl;
+    }
+    if (filename == "off") {
+        return;
+    }
+    if (!trace.open(filename)) {
+        std::cout << "Impossible to write the file" << std::endl;
+        return;
+    }
+    setThreadTrace(&trace);
+#else
+    if (filename != "off") {
+        std::cout << "The trace is not compiled in, build with 'make TRACE=1'" << std::endl;
+    }
+#endif
+}
+
+// Searches the bench positions to depth plies and prints the total number of
+// nodes (the signature), the time and the speed. Returns the exit code of the
+// program.
+int bench(int depth) {
+    BenchResult res = runBench(depth, std::cout);
+    std::cout << "depth " << depth << ", " << res.positions << " positions" << std::endl;
+    std::cout << "nodes " << res.nodes << std::endl;
+    std::cout << "time  " << std::fixed << std::setprecision(3) << res.seconds
+              << " s" << std::endl;
+    std::cout << "nps   " << std::setprecision(0) << res.nodes / res.seconds
+              << std::defaultfloat << std::endl;
+    SEARCH_STAT(printSearchStats(std::cout));
+    return res.errors == 0 ? 0 : 1;
+}
+
 void evaluateCommand(Game &g, const std::string &line) {
         std::vector<std::string> commands;
         tokenize(line, commands);
@@ -188,11 +288,10 @@ void evaluateCommand(Game &g, const std::string &line) {
             g.display();
         } else if (command == "?") {
             std::vector<Move *> moves = g.getAllLegalMoves();
-            std::vector<std::string> moves_str = AlgebraicNotation(moves);
-            for (auto x : moves_str) {
-                std::cout << x << " ";
-            }
-            std::cout << std::endl;
+            // a position has at most 218 legal moves
+            char moves_str[218 * MAX_SAN_LENGTH];
+            g.writeSANList(moves, moves_str, sizeof(moves_str));
+            std::cout << moves_str << std::endl;
         } else if (command == "help" || command == "h") {
             std::cout << "*move*: play *move* (type '?' for list of possible moves)" << std::endl;
             std::cout << "play s, p s, p: computer plays next move, s = strength" << std::endl;
@@ -202,6 +301,12 @@ void evaluateCommand(Game &g, const std::string &line) {
             std::cout << "undo, u: cancel last move" << std::endl;
             std::cout << "score, s: display the score of the game" << std::endl;
             std::cout << "openings file.txt, o file.txt: process the openings set in file.txt" << std::endl;
+            std::cout << "explore, explore file.idx: show the moves played from this position in the games of the position index file.idx" << std::endl;
+            std::cout << "bench, bench depth: search the bench positions and print the number of nodes and the speed" << std::endl;
+            std::cout << "stats, stats reset: print or reset the statistics of the searches (make STATS=1)" << std::endl;
+            std::cout << "trace file.trc, trace off: record the searches in file.trc, or stop (make TRACE=1)" << std::endl;
+            std::cout << "position fen *fen*, position startpos: start again from the position *fen* or the initial one" << std::endl;
+            std::cout << "fen: print the FEN of the current position" << std::endl;
             std::cout << "?: print all possible moves" << std::endl;
             std::cout << "quit, q: quit game" << std::endl;
             std::cout << "help, h: this message" << std::endl;
@@ -214,6 +319,46 @@ void evaluateCommand(Game &g, const std::string &line) {
         } else if (command == "open" || command == "o") {
             std::string filename = commands[1];
             process_openings(g, filename);
+        } else if (command == "explore") {
+            if (commands.size() > 1) {
+                PositionIndex *index = new PositionIndex();
+                if (!index->open(commands[1])) {
+                    std::cout << "Impossible to read the position index" << std::endl;
+                    delete index;
+                    return;
+                }
+                delete g.getPositionIndex();
+                g.setPositionIndex(index);
+            }
+            explore(g);
+        } else if (command == "position" && commands.size() > 1) {
+            std::string fen = START_FEN;
+            if (commands[1] == "fen") {
+                fen.clear();
+                for (size_t i = 2; i < commands.size(); i++) {
+                    fen += (i > 2 ? " " : "") + commands[i];
+                }
+            }
+            if (!g.setPosition(fen)) {
+                std::cout << "Invalid FEN, back to the initial position" << std::endl;
+            }
+            g.display();
+        } else if (command == "fen") {
+            std::cout << g.toFEN() << std::endl;
+        } else if (command == "bench") {
+            bench(commands.size() > 1 ? std::stoi(commands[1]) : BENCH_DEPTH);
+        } else if (command == "trace" && commands.size() > 1) {
+            traceCommand(commands[1]);
+        } else if (command == "stats") {
+#ifdef SEARCH_STATS
+            if (commands.size() > 1 && commands[1] == "reset") {
+                resetSearchStats();
+            } else {
+                printSearchStats(std::cout);
+            }
+#else
+            std::cout << "The statistics are not compiled in, build with 'make STATS=1'" << std::endl;
+#endif
         } else if (command == "play" || command == "p") {
             int strength = std::stoi(commands[1]);
             if (strength < 0 || strength > 5) {
@@ -227,34 +372,17 @@ void evaluateCommand(Game &g, const std::string &line) {
         } else if (command == "score" || command == "s") {
           g.display_heuristic();
         } else {
-            Move *m = parseAndValidate(g, line);
+            char promotion;
+            Move *m = parseAndValidate(g, command, &promotion);
             if (m == NULL) {
-               // Check if the line is in one of the following formats for example:
-               // {xd8Q, Rd3+, a0N}
-               // which basically means: is it in check (+), oris it Pawn Promotion
-               std::string last_member = line.substr(line.size()-1, 1);
-               if (last_member == "+") {
-                    m = parseAndValidate(g, line.substr(0, line.size()-1));
-                    if (m != NULL) {
-                      g.play(m);
-                      std::cout << m->toAlgebraicNotation(3) << std::endl;
-                      g.display();
-                      return;
-                    }
-               } else if (last_member == "B" || last_member == "R" || last_member == "Q" || last_member == "N") {
-                    m = parseAndValidate(g, line.substr(0, line.size()-1));
-                    if (m != NULL) {
-                      g.play(m);
-                      std::cout << line << std::endl;
-                      g.promote_pawn(m, last_member);
-                      g.display();
-                      return;
-                    }
-               }
                std::cout << "I didn't understand your move, try '?' for list of moves or 'help'" << std::endl;
             } else {
+               std::string san = g.toSAN(m, promotion);
                g.play(m);
-               std::cout << m->toAlgebraicNotation(3) << std::endl;
+               if (promotion != ' ') {
+                 g.promote_pawn(m, std::string(1, promotion));
+               }
+               std::cout << san << std::endl;
                g.display();
             }
         }
@@ -289,7 +417,286 @@ std::vector<std::string> parsing_file() {
   return game;
 }
 
-int main() {
+// Replays all the games of the PGN file filename on the workers of pool, and
+// reports the games that contain an illegal move. Returns the exit code of
+// the program.
+int replayFile(const std::string &filename, ThreadPool &pool) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<PgnGame> games;
+    if (!readPgnFile(filename, games)) {
+        std::cout << "Impossible to read the file" << std::endl;
+        return 1;
+    }
+    auto read = std::chrono::steady_clock::now();
+    std::vector<ReplayResult> results;
+    replayGames(games, pool, results);
+    auto end = std::chrono::steady_clock::now();
+
+    long plies = 0;
+    int errors = 0;
+    for (size_t i = 0; i < games.size(); i++) {
+        plies += results[i].plies;
+        if (results[i].error.empty()) {
+            continue;
+        }
+        errors++;
+        int ply = results[i].plies;
+        std::cout << "game " << i + 1 << " (" << games[i].tag("White") << " - "
+                  << games[i].tag("Black") << "): illegal move " << ply / 2 + 1
+                  << (ply % 2 == 0 ? "." : "...") << results[i].error << std::endl;
+    }
+    double read_s = std::chrono::duration<double>(read - start).count();
+    double replay_s = std::chrono::duration<double>(end - read).count();
+    std::cout << games.size() << " games, " << errors << " with errors, "
+              << plies << " plies" << std::endl;
+    std::cout << "read in " << read_s << " s, replayed in " << replay_s
+              << " s with " << pool.size() << " threads: "
+              << games.size() / replay_s << " games/s, "
+              << plies / replay_s << " plies/s" << std::endl;
+    return errors == 0 ? 0 : 1;
+}
+
+// Converts the PGN file pgn_filename to the game store store_filename.
+// Returns the exit code of the program.
+int importFile(const std::string &pgn_filename, const std::string &store_filename,
+               ThreadPool &pool) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<PgnGame> games;
+    if (!readPgnFile(pgn_filename, games)) {
+        std::cout << "Impossible to read the file" << std::endl;
+        return 1;
+    }
+    std::vector<size_t> rejected;
+    if (!writeGameStore(store_filename, games, pool, rejected)) {
+        std::cout << "Impossible to write the file" << std::endl;
+        return 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+    for (auto i : rejected) {
+        std::cout << "game " << i + 1 << " (" << games[i].tag("White") << " - "
+                  << games[i].tag("Black") << ") has an illegal move, skipped" << std::endl;
+    }
+    std::cout << games.size() - rejected.size() << " games stored in "
+              << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+    return 0;
+}
+
+// Replays all the games of the game store filename on the workers of pool,
+// or prints game n if n >= 0. Returns the exit code of the program.
+int storeReplayFile(const std::string &filename, long n, ThreadPool &pool) {
+    GameStore store;
+    if (!store.open(filename)) {
+        std::cout << "Impossible to read the game store" << std::endl;
+        return 1;
+    }
+    if (n >= 0) {
+        if ((size_t) n >= store.size()) {
+            std::cout << "There are only " << store.size() << " games" << std::endl;
+            return 1;
+        }
+        const GameRecord &r = store.record(n);
+        std::cout << store.player(r.white) << " - " << store.player(r.black)
+                  << ", " << r.date << ", " << std::string(r.eco, sizeof(r.eco)).c_str()
+                  << std::endl;
+        Board b;
+        int ply = 0;
+        bool ok = store.replay(n, b, [&ply](Board &b, Move *m, char promotion) {
+            if (ply % 2 == 0) {
+                std::cout << ply / 2 + 1 << ".";
+            }
+            std::cout << toSAN(b, m, promotion) << " ";
+            ply++;
+        });
+        std::cout << std::endl;
+        b.display();
+        return ok ? 0 : 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<long> plies(0);
+    std::atomic<int> errors(0);
+    std::vector<Board> boards(pool.size());
+    parallelFor(pool, store.size(), [&](size_t i, int worker) {
+        if (store.replay(i, boards[worker], MoveVisitor())) {
+            plies += store.record(i).plies;
+        } else {
+            errors++;
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << store.size() << " games, " << errors << " corrupt, " << plies
+              << " plies replayed in " << seconds << " s with " << pool.size()
+              << " threads: " << plies / seconds << " plies/s" << std::endl;
+    return errors == 0 ? 0 : 1;
+}
+
+// Counts the leaves of the tree of legal moves of depth depth from the
+// position fen on the workers of pool, and prints them for each move.
+// Returns the exit code of the program.
+int perftCommand(int depth, const std::string &fen, ThreadPool &pool) {
+    Board b;
+    if (!b.fromFEN(fen)) {
+        std::cerr << "invalid FEN: " << fen << std::endl;
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::pair<std::string, uint64_t> > divide;
+    uint64_t leaves = parallelPerft(pool, fen, depth, &divide);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (const auto &d : divide) {
+        std::cout << d.first << ": " << d.second << std::endl;
+    }
+    std::cout << "perft " << depth << ": " << leaves << " leaves in " << seconds
+              << " s with " << pool.size() << " threads: " << leaves / seconds
+              << " leaves/s" << std::endl;
+    return 0;
+}
+
+// Analyses the positions of filename (see analysis.h) on the workers of pool,
+// to depth plies unless the file sets other limits. The results are written
+// on the standard output and the totals on the error output. Returns the exit
+// code of the program.
+int analyzeFile(const std::string &filename, int depth, ThreadPool &pool) {
+    AnalysisLimits limits;
+    limits.depth = depth;
+    std::vector<AnalysisJob> jobs;
+    if (!readAnalysisFile(filename, limits, jobs)) {
+        std::cout << "Impossible to read the file" << std::endl;
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    AnalysisSummary s = analyzePositions(jobs, pool, ANALYSIS_TT_MB, std::cout);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << s.positions << " positions analysed, " << s.errors << " errors, in "
+              << seconds << " s with " << pool.size() << " threads: " << s.nodes / seconds
+              << " nodes/s" << std::endl;
+    return s.errors == 0 ? 0 : 1;
+}
+
+// Plays the match of the configurations a and b (see match.h) from the
+// openings of filename on the workers of pool, the progress being written on
+// the error output. Returns the exit code of the program.
+int matchCommand(const std::string &a, const std::string &b, const std::string &filename,
+                 const MatchOptions &options, ThreadPool &pool) {
+    EngineConfig configs[2];
+    if (!parseEngineConfig(a, configs[0]) || !parseEngineConfig(b, configs[1])) {
+        std::cout << "Invalid configuration, e.g. base:nodes=20000,tt=16" << std::endl;
+        return 1;
+    }
+    std::vector<PgnGame> openings;
+    if (!readOpenings(filename, openings) || openings.empty()) {
+        std::cout << "Impossible to read the openings" << std::endl;
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    MatchResult r = playMatch(configs[0], configs[1], openings, options, pool, std::cerr);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << configs[0].name << " vs " << configs[1].name << ", ";
+    writeMatchResult(r, std::cout);
+    std::cout << "sprt: " << (r.sprt > 0 ? "elo1 accepted" : r.sprt < 0 ? "elo0 accepted" :
+                              "no decision")
+              << ", " << r.errors << " openings not playable, " << r.games() / seconds
+              << " games/s with " << pool.size() << " threads" << std::endl;
+    return r.errors == 0 ? 0 : 1;
+}
+
+// Generates options.positions positions in the shards of output (see
+// datagen.h) on the workers of pool. Returns the exit code of the program.
+int datagenCommand(const std::string &output, const DatagenOptions &options, ThreadPool &pool) {
+    auto start = std::chrono::steady_clock::now();
+    DatagenSummary s;
+    if (!generateData(output, options, pool, std::cerr, &s)) {
+        std::cout << "Impossible to write the shards of " << output << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << s.positions << " positions from " << s.games - s.dropped << " games ("
+              << s.dropped << " openings dropped) in " << seconds << " s with " << pool.size()
+              << " threads: " << s.positions / seconds << " positions/s" << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    // the number of workers of the thread pool, one per hardware thread by
+    // default
+    int nthreads = 0;
+    if (argc >= 3 && std::string(argv[1]) == "replay") {
+        nthreads = (argc >= 4) ? std::stoi(argv[3]) : nthreads;
+        ThreadPool pool(nthreads);
+        return replayFile(argv[2], pool);
+    }
+    if (argc >= 4 && std::string(argv[1]) == "import") {
+        nthreads = (argc >= 5) ? std::stoi(argv[4]) : nthreads;
+        ThreadPool pool(nthreads);
+        return importFile(argv[2], argv[3], pool);
+    }
+    if (argc >= 4 && std::string(argv[1]) == "index") {
+        nthreads = (argc >= 5) ? std::stoi(argv[4]) : nthreads;
+        size_t memory_mb = (argc >= 6) ? std::stoul(argv[5]) : 256;
+        size_t games;
+        auto start = std::chrono::steady_clock::now();
+        ThreadPool pool(nthreads);
+        if (!buildPositionIndex(argv[2], argv[3], pool, memory_mb, &games)) {
+            std::cout << "Impossible to build the position index" << std::endl;
+            return 1;
+        }
+        std::cout << games << " games indexed in " << std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+        return 0;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "storereplay") {
+        long n = (argc >= 4) ? std::stol(argv[3]) : -1;
+        ThreadPool pool(nthreads);
+        return storeReplayFile(argv[2], n, pool);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "perft") {
+        nthreads = (argc >= 4) ? std::stoi(argv[3]) : nthreads;
+        std::string fen = START_FEN;
+        if (argc >= 5) {
+            // the fields of the FEN may be given as separate arguments
+            fen = argv[4];
+            for (int i = 5; i < argc; i++) {
+                fen += std::string(" ") + argv[i];
+            }
+        }
+        ThreadPool pool(nthreads);
+        return perftCommand(std::stoi(argv[2]), fen, pool);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "analyze") {
+        int depth = (argc >= 4) ? std::stoi(argv[3]) : AnalysisLimits().depth;
+        nthreads = (argc >= 5) ? std::stoi(argv[4]) : nthreads;
+        ThreadPool pool(nthreads);
+        return analyzeFile(argv[2], depth, pool);
+    }
+    if (argc >= 5 && std::string(argv[1]) == "match") {
+        MatchOptions options;
+        options.games = (argc >= 6) ? std::stol(argv[5]) : options.games;
+        nthreads = (argc >= 7) ? std::stoi(argv[6]) : nthreads;
+        options.elo0 = (argc >= 8) ? std::stod(argv[7]) : options.elo0;
+        options.elo1 = (argc >= 9) ? std::stod(argv[8]) : options.elo1;
+        ThreadPool pool(nthreads);
+        return matchCommand(argv[2], argv[3], argv[4], options, pool);
+    }
+    if (argc >= 4 && std::string(argv[1]) == "datagen") {
+        DatagenOptions options;
+        options.positions = std::stol(argv[3]);
+        nthreads = (argc >= 5) ? std::stoi(argv[4]) : nthreads;
+        options.nodes = (argc >= 6) ? std::stol(argv[5]) : options.nodes;
+        options.seed = (argc >= 7) ? std::stoull(argv[6]) : options.seed;
+        ThreadPool pool(nthreads);
+        return datagenCommand(argv[2], options, pool);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--uci") {
+        return runUci(std::cin, std::cout);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "bench") {
+        if (argc >= 4) {
+            traceCommand(argv[3]);
+        }
+        int res = bench(argc >= 3 ? std::stoi(argv[2]) : BENCH_DEPTH);
+        traceCommand("off");
+        return res;
+    }
     Game g;
     std::string line;
     std::vector<std::string> gameMoves = parsing_file();
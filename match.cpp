@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include "match.h"
+#include "analysis.h"
+#include "board.h"
+#include "piece.h"
+#include "replay.h"
+#include "search.h"
+#include "transposition.h"
+
+// the games between two lines with the results so far
+static const long REPORT_GAMES = 20;
+
+// the games before the SPRT may end the match: the variance of the score
+// estimated from fewer games is too unreliable
+static const long SPRT_MIN_GAMES = 20;
+
+bool parseEngineConfig(const std::string &text, EngineConfig &config) {
+    config = EngineConfig();
+    config.name = text;
+    size_t colon = text.find(':');
+    std::string list = text;
+    if (colon != std::string::npos) {
+        config.name = text.substr(0, colon);
+        list = text.substr(colon + 1);
+    } else if (text.find('=') == std::string::npos) {
+        // only a name
+        return true;
+    }
+    std::istringstream settings(list);
+    std::string setting;
+    while (std::getline(settings, setting, ',')) {
+        size_t equal = setting.find('=');
+        if (equal == std::string::npos) {
+            return false;
+        }
+        std::string key = setting.substr(0, equal);
+        long value = std::atol(setting.c_str() + equal + 1);
+        if (value < 0) {
+            return false;
+        }
+        if (key == "depth") {
+            config.depth = value;
+        } else if (key == "nodes") {
+            config.nodes = value;
+        } else if (key == "movetime") {
+            config.movetime = value;
+        } else if (key == "tt") {
+            config.tt_mb = value;
+        } else if (key == "evalcache") {
+            config.eval_cache_kb = value;
+        } else if (key == "mobility" || key == "kingsafety" || key == "shield") {
+            if (value > 1) {
+                return false;
+            }
+            int term = (key == "mobility") ? EVAL_MOBILITY :
+                       (key == "kingsafety") ? EVAL_KING_SAFETY : EVAL_PAWN_SHIELD;
+            config.eval_terms = value ? config.eval_terms | term : config.eval_terms & ~term;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readOpenings(const std::string &filename, std::vector<PgnGame> &openings) {
+    if (filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".pgn") == 0) {
+        std::vector<PgnGame> games;
+        if (!readPgnFile(filename, games)) {
+            return false;
+        }
+        for (auto &g : games) {
+            PgnGame opening;
+            std::string fen = g.tag("FEN");
+            if (!fen.empty()) {
+                opening.tags.push_back(std::make_pair(std::string("FEN"), fen));
+            }
+            size_t plies = std::min<size_t>(g.moves.size(), MATCH_OPENING_PLIES);
+            opening.moves.assign(g.moves.begin(), g.moves.begin() + plies);
+            openings.push_back(std::move(opening));
+        }
+        return true;
+    }
+    std::vector<AnalysisJob> jobs;
+    if (!readAnalysisFile(filename, AnalysisLimits(), jobs)) {
+        return false;
+    }
+    for (auto &job : jobs) {
+        PgnGame opening;
+        if (!job.fen.empty()) {
+            opening.tags.push_back(std::make_pair(std::string("FEN"), job.fen));
+        }
+        opening.moves = std::move(job.moves);
+        openings.push_back(std::move(opening));
+    }
+    return true;
+}
+
+static double eloFromScore(double score) {
+    score = std::min(std::max(score, 1e-6), 1 - 1e-6);
+    return -400 * std::log10(1 / score - 1);
+}
+
+static double scoreFromElo(double elo) {
+    return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+void computeMatchStats(const MatchOptions &options, MatchResult &r) {
+    r.lower = std::log(options.beta / (1 - options.alpha));
+    r.upper = std::log((1 - options.beta) / options.alpha);
+    long n = r.games();
+    if (n == 0) {
+        return;
+    }
+    // the mean and the variance of the score of a game
+    double score = (r.wins + 0.5 * r.draws) / n;
+    double variance = (r.wins * (1 - score) * (1 - score) + r.losses * score * score +
+                       r.draws * (0.5 - score) * (0.5 - score)) / n;
+    double error = 1.96 * std::sqrt(variance / n);
+    r.elo = eloFromScore(score);
+    r.elo_error = (eloFromScore(score + error) - eloFromScore(score - error)) / 2;
+    // the normal approximation of the log-likelihood ratio
+    r.llr = 0;
+    r.sprt = 0;
+    if (variance > 0) {
+        double score0 = scoreFromElo(options.elo0);
+        double score1 = scoreFromElo(options.elo1);
+        r.llr = (score1 - score0) * (2 * score - score0 - score1) * n / (2 * variance);
+    }
+    if (n >= SPRT_MIN_GAMES) {
+        r.sprt = (r.llr >= r.upper) ? 1 : (r.llr <= r.lower) ? -1 : 0;
+    }
+}
+
+// the players of a worker, one per configuration
+struct MatchWorker {
+    Board board;
+    Search search[2];
+    std::unique_ptr<TranspositionTable> tt[2];
+};
+
+static GameOutcome winner(Color c) {
+    return (c == WHITE) ? WHITE_WINS : BLACK_WINS;
+}
+
+GameOutcome gameOutcome(Board &b, int plies) {
+    Color player = b.getPlayer();
+    if (!b.hasLegalMove()) {
+        return b.isInCheck(player) ? winner(player == WHITE ? BLACK : WHITE) : DRAWN;
+    }
+    if (b.isDraw(2) || plies >= MATCH_MAX_PLIES) {
+        return DRAWN;
+    }
+    return NOT_OVER;
+}
+
+// plays the game from opening on the board of w, configs[k] being played by
+// w.search[k], and white (0 or 1) playing White. Returns false if the
+// opening can't be played.
+static bool playGame(MatchWorker &w, const PgnGame &opening, const EngineConfig *configs[2],
+                     int white, GameOutcome *outcome) {
+    Board &b = w.board;
+    ReplayResult res;
+    if (!replayGame(b, opening, res, MoveVisitor())) {
+        return false;
+    }
+    for (int k = 0; k < 2; k++) {
+        if (w.tt[k]) {
+            w.tt[k]->clear();
+        }
+    }
+    for (int ply = 0; ; ply++) {
+        *outcome = gameOutcome(b, ply);
+        if (*outcome != NOT_OVER) {
+            return true;
+        }
+        Color player = b.getPlayer();
+        int k = (player == WHITE) ? white : 1 - white;
+        const EngineConfig &c = *configs[k];
+        b.setEvalTerms(c.eval_terms);
+        SearchResult r = w.search[k].run(b, c.depth, c.nodes, c.movetime);
+        if (r.score > MATE - 1000) {
+            deletePV(r, NULL);
+            *outcome = winner(player);
+            return true;
+        }
+        Move *m = r.best;
+        bool promotes = m->isPromotion();
+        m->perform(&b);
+        b.switch_player();
+        if (promotes) {
+            b.promote_pawn_b(m, "Q");
+        }
+        deletePV(r, NULL);
+    }
+}
+
+void writeMatchResult(const MatchResult &r, std::ostream &out) {
+    out << "games " << r.games() << ": +" << r.wins << " -" << r.losses << " =" << r.draws
+        << std::fixed << std::setprecision(1) << ", elo " << r.elo << " +- " << r.elo_error
+        << std::setprecision(2) << ", llr " << r.llr << " [" << r.lower << ", " << r.upper
+        << "]" << std::defaultfloat << std::endl;
+}
+
+MatchResult playMatch(const EngineConfig &a, const EngineConfig &b,
+                      const std::vector<PgnGame> &openings, const MatchOptions &options,
+                      ThreadPool &pool, std::ostream &log) {
+    EngineConfig configs[2] = {a, b};
+    for (auto &c : configs) {
+        if (c.depth == 0) {
+            c.depth = (c.nodes > 0 || c.movetime > 0) ? MAX_SEARCH_DEPTH : 4;
+        }
+    }
+    std::vector<MatchWorker> workers(pool.size());
+    for (auto &w : workers) {
+        for (int k = 0; k < 2; k++) {
+            if (configs[k].tt_mb > 0) {
+                w.tt[k].reset(new TranspositionTable(configs[k].tt_mb));
+                w.search[k].setTable(w.tt[k].get());
+            }
+            if (configs[k].eval_cache_kb != EVAL_CACHE_KB) {
+                w.search[k].setEvalCacheSize(configs[k].eval_cache_kb);
+            }
+        }
+    }
+    MatchResult result;
+    computeMatchStats(options, result);
+    std::mutex mutex;
+    std::atomic<bool> decided(false);
+    long games = (options.games + 1) / 2 * 2;
+    parallelFor(pool, openings.empty() ? 0 : games, [&](size_t i, int worker) {
+        if (decided) {
+            return;
+        }
+        // the games of a pair play the same opening, a plays White in the first
+        const EngineConfig *players[2] = {&configs[0], &configs[1]};
+        int white = i % 2;
+        GameOutcome outcome;
+        bool played = playGame(workers[worker], openings[(i / 2) % openings.size()], players,
+                               white, &outcome);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!played) {
+            result.errors++;
+            return;
+        }
+        if (decided) {
+            return;
+        }
+        if (outcome == DRAWN) {
+            result.draws++;
+        } else if ((outcome == WHITE_WINS) == (white == 0)) {
+            result.wins++;
+        } else {
+            result.losses++;
+        }
+        computeMatchStats(options, result);
+        if (result.sprt != 0) {
+            decided = true;
+        }
+        if (result.games() % REPORT_GAMES == 0 || decided) {
+            writeMatchResult(result, log);
+        }
+    });
+    return result;
+}
@@ -0,0 +1,130 @@
+// This module plays matches between two configurations of the engine, to
+// check that a change of the search gains strength before keeping it:
+//
+//   main match configA configB openings [games] [threads] [elo0] [elo1]
+//
+// A configuration gives the limits of each move and the transposition table,
+// e.g. "base:nodes=20000,tt=16" (see parseEngineConfig()). Fixed nodes make
+// the games independent of the speed of the machine and of its load; a time
+// per move (movetime) measures the speed as well. A configuration may also
+// switch off terms of the evaluation, e.g. "nomob:nodes=20000,mobility=0",
+// to weigh their cost against their strength.
+//
+// Each opening (see readOpenings()) is played twice, each configuration
+// playing White once, and the games are shared among the workers of a
+// thread pool, one game per worker at a time. A game ends by mate or
+// stalemate, by the fifty-move rule, a threefold repetition or insufficient
+// material, or is adjudicated when the player to move announces a mate (the
+// search proves it, there are no tablebases) or after MATCH_MAX_PLIES plies
+// (a draw). The tables are cleared before each game, so its result doesn't
+// depend on the games played before by the same worker.
+//
+// The results give the Elo difference of the first configuration over the
+// second, with its 95% error bar, and a sequential probability ratio test
+// (SPRT) of the hypotheses "elo = elo0" against "elo = elo1": the match
+// stops as soon as one of them is accepted (not before 20 games), with error
+// rates of 5%.
+// see https://www.chessprogramming.org/Sequential_Probability_Ratio_Test
+
+#ifndef MATCH_H_
+#define MATCH_H_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "evalcache.h"
+#include "pgn.h"
+#include "threadpool.h"
+
+// the plies after which a game is adjudicated a draw
+const int MATCH_MAX_PLIES = 400;
+
+// the plies of each game of a PGN file kept as an opening
+const int MATCH_OPENING_PLIES = 8;
+
+enum GameOutcome { WHITE_WINS, BLACK_WINS, DRAWN, NOT_OVER };
+
+// returns the outcome of the game on b after plies plies: mate, stalemate, or
+// a draw by the fifty-move rule, a threefold repetition, insufficient
+// material (see Board::isDraw()) or after MATCH_MAX_PLIES plies.
+GameOutcome gameOutcome(Board &b, int plies);
+
+struct EngineConfig {
+    std::string name;
+    // the limits of each move, 0 for none, see Search::run(). Without any,
+    // the depth is 4.
+    int depth = 0;
+    long nodes = 0;
+    long movetime = 0;
+    // the size of the transposition table in megabytes, 0 for none
+    size_t tt_mb = 0;
+    // the size of the evaluation cache in kilobytes, 0 for none
+    size_t eval_cache_kb = EVAL_CACHE_KB;
+    // the terms of the evaluation, see Board::setEvalTerms()
+    int eval_terms = EVAL_ALL_TERMS;
+};
+
+// parses the configuration text, "name:key=value,key=value..." (the name and
+// each key being optional) with the keys depth, nodes, movetime (ms), tt
+// (mb), evalcache (kb), and mobility, kingsafety and shield (0 or 1, to switch off or on the
+// terms of the evaluation, see eval.h), into config.
+// returns false if text is not valid.
+bool parseEngineConfig(const std::string &text, EngineConfig &config);
+
+// reads the openings of filename, as games without result: the first
+// MATCH_OPENING_PLIES plies of each game of a PGN file, otherwise the
+// positions of a list of FEN, EPD or SAN lines (see analysis.h).
+// returns false if the file can't be read.
+bool readOpenings(const std::string &filename, std::vector<PgnGame> &openings);
+
+struct MatchOptions {
+    // the number of games, rounded up to pairs of games
+    long games = 1000;
+    // the hypotheses of the SPRT, in Elo of the first configuration
+    double elo0 = 0;
+    double elo1 = 5;
+    // the error rates of the SPRT
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+struct MatchResult {
+    // the results of the first configuration
+    long wins = 0;
+    long losses = 0;
+    long draws = 0;
+    // the games with an opening that can't be played
+    long errors = 0;
+    // the Elo difference and the half-width of its 95% confidence interval
+    double elo = 0;
+    double elo_error = 0;
+    // the log-likelihood ratio of the SPRT and its bounds
+    double llr = 0;
+    double lower = 0;
+    double upper = 0;
+    // 1 if elo1 is accepted, -1 if elo0 is, 0 if the test goes on
+    int sprt = 0;
+
+    long games() const {
+        return wins + losses + draws;
+    }
+};
+
+// computes the Elo, its error and the SPRT of r from its wins, losses and
+// draws
+void computeMatchStats(const MatchOptions &options, MatchResult &r);
+
+// writes the results of r on one line, e.g.
+//   games 200: +70 -50 =80, elo 34.9 +- 38.6, llr 1.21 [-2.94, 2.94]
+void writeMatchResult(const MatchResult &r, std::ostream &out);
+
+// plays the match of a against b on the workers of pool, the openings being
+// used in turn. A line with the results so far is written on log every 20
+// games, and when the SPRT ends the match.
+MatchResult playMatch(const EngineConfig &a, const EngineConfig &b,
+                      const std::vector<PgnGame> &openings, const MatchOptions &options,
+                      ThreadPool &pool, std::ostream &log);
+
+#endif // MATCH_H_
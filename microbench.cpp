@@ -0,0 +1,408 @@
+// This program times the hot primitives of the engine one by one, to catch a
+// regression in a function before it shows in the search (see bench.h for
+// the search itself).
+//
+//   microbench [-r repetitions] [-f filter] [-o results.json] [file.pgn]
+//
+// The corpus is made of positions of the games of file.pgn (Akobian.pgn by
+// default): every POSITION_STRIDE plies of every GAME_STRIDE game, so that it
+// doesn't change from one commit to the next. A sample is one pass of a
+// primitive over the whole corpus, divided by the number of calls. After a
+// few warm-up passes, repetitions samples are timed, and their minimum,
+// percentiles and mean are printed, in nanoseconds per call. With -o, they
+// are also written as JSON, to be compared with the file of another commit.
+// -f only runs the primitives whose name contains filter.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "move.h"
+#include "piece.h"
+#include "notation.h"
+#include "pgn.h"
+#include "replay.h"
+#include "search.h"
+
+const int GAME_STRIDE = 10;
+const int POSITION_STRIDE = 8;
+const int WARMUP = 5;
+
+// a position of the corpus, with its moves computed once
+struct CorpusPosition {
+    std::unique_ptr<Board> board;
+    std::vector<Move *> pseudo;
+    std::vector<Move *> legal;
+    std::vector<std::string> san;
+    std::string fen;
+};
+
+struct Primitive {
+    const char *name;
+    // false if the primitive doesn't depend on the position: it is then run
+    // once per pass instead of once per position
+    bool per_position;
+    // runs the primitive on position p, returns the number of calls
+    std::function<long(CorpusPosition &p)> run;
+    // true to run it with the attack maps maintained by the boards of the
+    // corpus, see Board::trackAttacks()
+    bool attack_maps = false;
+};
+
+// the depth of the searches timed as a primitive
+const int SEARCH_DEPTH = 2;
+
+// the results of the primitives are stored here, so that the calls are not
+// optimized out
+static volatile long sink;
+
+// returns the letter of the piece m promotes to in the corpus, or ' '
+static char promotionOf(const Move *m) {
+    return m->isPromotion() ? 'Q' : ' ';
+}
+
+struct Timing {
+    std::string name;
+    long calls = 0;
+    // ns per call, one per sample, sorted
+    std::vector<double> samples;
+
+    double percentile(double q) const {
+        size_t k = std::min(samples.size() - 1, (size_t) (q * samples.size()));
+        return samples[k];
+    }
+
+    double mean() const {
+        double sum = 0;
+        for (double s : samples) {
+            sum += s;
+        }
+        return sum / samples.size();
+    }
+};
+
+// reads the corpus from the games of filename, returns false if it can't be
+// read
+static bool readCorpus(const std::string &filename, std::vector<CorpusPosition> &corpus) {
+    std::vector<PgnGame> games;
+    if (!readPgnFile(filename, games)) {
+        return false;
+    }
+    for (size_t i = 0; i < games.size(); i += GAME_STRIDE) {
+        PgnGame prefix;
+        for (size_t ply = 0; ply < games[i].moves.size(); ply += POSITION_STRIDE) {
+            prefix.moves.assign(games[i].moves.begin(), games[i].moves.begin() + ply);
+            CorpusPosition p;
+            p.board.reset(new Board());
+            ReplayResult res;
+            if (!replayGame(*p.board, prefix, res, MoveVisitor())) {
+                break;
+            }
+            p.pseudo = p.board->getAllMoves();
+            p.legal = p.board->getAllLegalMoves();
+            for (auto m : p.legal) {
+                p.san.push_back(toSAN(*p.board, m, promotionOf(m)));
+            }
+            p.fen = p.board->toFEN();
+            corpus.push_back(std::move(p));
+        }
+    }
+    return true;
+}
+
+static long deleteMoves(std::vector<Move *> moves) {
+    sink = moves.size();
+    for (auto m : moves) {
+        delete m;
+    }
+    return 1;
+}
+
+// computes with f the attacks of the sliders of each player of p, as
+// Board::attackMap() does, returns the number of calls
+static long slidingAttacksOf(CorpusPosition &p, Bitboard (*f)(Bitboard, Bitboard, Bitboard)) {
+    const Board &b = *p.board;
+    for (Color c : {WHITE, BLACK}) {
+        Bitboard queens = b.pieces(pieceCode(QUEEN, c));
+        sink = f(b.pieces(pieceCode(BISHOP, c)) | queens, b.pieces(pieceCode(ROOK, c)) | queens,
+                 b.occupancy());
+    }
+    return 2;
+}
+
+// evaluates p with the EvalTerms terms only, returns the number of calls
+static long evaluateWith(CorpusPosition &p, int terms) {
+    p.board->setEvalTerms(terms);
+    sink = p.board->evaluate();
+    p.board->setEvalTerms(EVAL_ALL_TERMS);
+    return 1;
+}
+
+static std::vector<Primitive> primitives(const std::string &pgn_text) {
+    std::vector<Primitive> res;
+    res.push_back({"Board::getAllMoves", true, [](CorpusPosition &p) {
+        return deleteMoves(p.board->getAllMoves());
+    }});
+    res.push_back({"Board::getAllLegalMoves", true, [](CorpusPosition &p) {
+        return deleteMoves(p.board->getAllLegalMoves());
+    }});
+    res.push_back({"Board::getAllLegalMoves(CAPTURES)", true, [](CorpusPosition &p) {
+        return deleteMoves(p.board->getAllLegalMoves(CAPTURES));
+    }});
+    res.push_back({"Board::hasLegalMove", true, [](CorpusPosition &p) {
+        sink = p.board->hasLegalMove();
+        return 1L;
+    }});
+    res.push_back({"Board::countLegalMoves", true, [](CorpusPosition &p) {
+        sink = p.board->countLegalMoves();
+        return 1L;
+    }});
+    res.push_back({"Board::isInCheck", true, [](CorpusPosition &p) {
+        sink = p.board->isInCheck(p.board->getPlayer());
+        return 1L;
+    }});
+    res.push_back({"Board::heuristic", true, [](CorpusPosition &p) {
+        sink = p.board->heuristic();
+        return 1L;
+    }});
+    // the cost of each term of the evaluation, over the material and the
+    // placement of the pieces alone
+    res.push_back({"Board::evaluate [no terms]", true, [](CorpusPosition &p) {
+        return evaluateWith(p, 0);
+    }});
+    res.push_back({"Board::evaluate [mobility]", true, [](CorpusPosition &p) {
+        return evaluateWith(p, EVAL_MOBILITY);
+    }});
+    res.push_back({"Board::evaluate [king safety]", true, [](CorpusPosition &p) {
+        return evaluateWith(p, EVAL_KING_SAFETY);
+    }});
+    res.push_back({"Board::evaluate [pawn shield]", true, [](CorpusPosition &p) {
+        return evaluateWith(p, EVAL_PAWN_SHIELD);
+    }});
+    res.push_back({"Board::evaluate", true, [](CorpusPosition &p) {
+        return evaluateWith(p, EVAL_ALL_TERMS);
+    }});
+    res.push_back({"Board::reachablePositionsAlongStraightLine", true, [](CorpusPosition &p) {
+        // the 8 directions from every piece of the current player
+        static const int dirs[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1},
+                                       {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+        std::vector<Position> reached;
+        long calls = 0;
+        Color pl = p.board->getPlayer();
+        for (unsigned int i = 0; i < 8; i++) {
+            for (unsigned int j = 0; j < 8; j++) {
+                Piece *piece;
+                if (!p.board->getPiece({i, j}, &piece) || piece->getColor() != pl) {
+                    continue;
+                }
+                for (const auto &d : dirs) {
+                    reached.clear();
+                    p.board->reachablePositionsAlongStraightLine({i, j}, d[0], d[1], 8,
+                                                                 pl, true, reached);
+                    sink = reached.size();
+                    calls++;
+                }
+            }
+        }
+        return calls;
+    }});
+    // the attack maps of the sliders by each method
+    res.push_back({"slidingAttacksMagic", true, [](CorpusPosition &p) {
+        return slidingAttacksOf(p, slidingAttacksMagic);
+    }});
+    res.push_back({"slidingAttacksScalar", true, [](CorpusPosition &p) {
+        return slidingAttacksOf(p, slidingAttacksScalar);
+    }});
+    if (hasAvx2()) {
+        res.push_back({"slidingAttacksAvx2", true, [](CorpusPosition &p) {
+            return slidingAttacksOf(p, slidingAttacksAvx2);
+        }});
+    }
+    // the same primitives with and without the attack maps maintained, to
+    // compare their cost on the moves with their gain on the lookups
+    for (bool maps : {false, true}) {
+        res.push_back({maps ? "Move::perform+unPerform [maps]" : "Move::perform+unPerform",
+                       true, [](CorpusPosition &p) {
+            for (auto m : p.legal) {
+                m->perform(p.board.get());
+                m->unPerform(p.board.get());
+            }
+            return (long) p.legal.size();
+        }, maps});
+        res.push_back({maps ? "Board::isLegal [maps]" : "Board::isLegal", true,
+                       [](CorpusPosition &p) {
+            for (auto m : p.pseudo) {
+                sink = p.board->isLegal(m);
+            }
+            return (long) p.pseudo.size();
+        }, maps});
+        res.push_back({maps ? "Board::attackMap [maps]" : "Board::attackMap", true,
+                       [](CorpusPosition &p) {
+            sink = p.board->attackMap(WHITE) | p.board->attackMap(BLACK);
+            return 2L;
+        }, maps});
+        // a call is a search of the position
+        res.push_back({maps ? "Search::run [maps]" : "Search::run", true,
+                       [](CorpusPosition &p) {
+            Search search;
+            SearchResult r = search.run(*p.board, SEARCH_DEPTH);
+            sink = r.nodes;
+            deletePV(r, NULL);
+            return 1L;
+        }, maps});
+    }
+    res.push_back({"writeSAN", true, [](CorpusPosition &p) {
+        char buf[MAX_SAN_LENGTH];
+        for (auto m : p.legal) {
+            sink = writeSAN(*p.board, m, promotionOf(m), buf);
+        }
+        return (long) p.legal.size();
+    }});
+    res.push_back({"parseMove", true, [](CorpusPosition &p) {
+        char promotion;
+        for (const auto &san : p.san) {
+            delete parseMove(*p.board, san, &promotion);
+        }
+        return (long) p.san.size();
+    }});
+    res.push_back({"Board::fromFEN", true, [](CorpusPosition &p) {
+        // loaded in another board, the one of the corpus is shared
+        static Board b;
+        sink = b.fromFEN(p.fen);
+        return 1L;
+    }});
+    res.push_back({"Board::toFEN", true, [](CorpusPosition &p) {
+        sink = p.board->toFEN().size();
+        return 1L;
+    }});
+    // a call is the reading of one game of the file
+    res.push_back({"readPgnGame", false, [pgn_text](CorpusPosition &) {
+        std::istringstream in(pgn_text);
+        PgnGame g;
+        long calls = 0;
+        while (readPgnGame(in, g)) {
+            calls++;
+        }
+        return calls;
+    }});
+    return res;
+}
+
+// times repetitions passes of primitive over the corpus
+static Timing measure(const Primitive &primitive, std::vector<CorpusPosition> &corpus,
+                      int repetitions) {
+    size_t count = primitive.per_position ? corpus.size() : 1;
+    auto pass = [&]() {
+        long calls = 0;
+        for (size_t k = 0; k < count; k++) {
+            calls += primitive.run(corpus[k]);
+        }
+        return calls;
+    };
+    Timing t;
+    t.name = primitive.name;
+    for (auto &p : corpus) {
+        p.board->trackAttacks(primitive.attack_maps);
+    }
+    for (int i = 0; i < WARMUP; i++) {
+        pass();
+    }
+    for (int i = 0; i < repetitions; i++) {
+        auto start = std::chrono::steady_clock::now();
+        t.calls = pass();
+        double ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+        t.samples.push_back(ns / std::max(1L, t.calls));
+    }
+    std::sort(t.samples.begin(), t.samples.end());
+    for (auto &p : corpus) {
+        p.board->trackAttacks(false);
+    }
+    return t;
+}
+
+static void writeJson(std::ostream &out, const std::string &corpus_file, size_t positions,
+                      int repetitions, const std::vector<Timing> &timings) {
+    out << std::fixed << std::setprecision(1);
+    out << "{\n";
+    out << "  \"corpus\": \"" << corpus_file << "\",\n";
+    out << "  \"positions\": " << positions << ",\n";
+    out << "  \"warmup\": " << WARMUP << ",\n";
+    out << "  \"repetitions\": " << repetitions << ",\n";
+    out << "  \"unit\": \"ns/call\",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < timings.size(); i++) {
+        const Timing &t = timings[i];
+        out << "    {\"name\": \"" << t.name << "\", \"calls\": " << t.calls
+            << ", \"min\": " << t.samples.front()
+            << ", \"p50\": " << t.percentile(0.5)
+            << ", \"p90\": " << t.percentile(0.9)
+            << ", \"p99\": " << t.percentile(0.99)
+            << ", \"mean\": " << t.mean() << "}"
+            << (i + 1 < timings.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+int main(int argc, char **argv) {
+    std::string corpus_file = "Akobian.pgn";
+    std::string json_file;
+    std::string filter;
+    int repetitions = 50;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc) {
+            repetitions = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-f" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            json_file = argv[++i];
+        } else {
+            corpus_file = arg;
+        }
+    }
+
+    std::vector<CorpusPosition> corpus;
+    std::ifstream file(corpus_file);
+    std::stringstream pgn_text;
+    pgn_text << file.rdbuf();
+    if (!readCorpus(corpus_file, corpus) || corpus.empty()) {
+        std::cout << "Impossible to read the file" << std::endl;
+        return 1;
+    }
+    std::cout << corpus.size() << " positions, " << repetitions << " repetitions"
+              << std::endl;
+    std::cout << std::left << std::setw(44) << "primitive (ns/call)" << std::right
+              << std::setw(10) << "min" << std::setw(10) << "p50"
+              << std::setw(10) << "p90" << std::setw(10) << "p99" << std::endl;
+    std::vector<Timing> timings;
+    for (const auto &primitive : primitives(pgn_text.str())) {
+        if (std::string(primitive.name).find(filter) == std::string::npos) {
+            continue;
+        }
+        Timing t = measure(primitive, corpus, repetitions);
+        std::cout << std::left << std::setw(44) << t.name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << t.samples.front() << std::setw(10) << t.percentile(0.5)
+                  << std::setw(10) << t.percentile(0.9) << std::setw(10) << t.percentile(0.99)
+                  << std::defaultfloat << std::endl;
+        timings.push_back(t);
+    }
+    if (!json_file.empty()) {
+        std::ofstream out(json_file);
+        writeJson(out, corpus_file, corpus.size(), repetitions, timings);
+        if (!out) {
+            std::cout << "Impossible to write " << json_file << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -3,12 +3,19 @@
 #include <iostream>
 #include <cassert>
 
+bool Move::isPromotion() const {
+    Position to = getTo();
+    return getMoved()->notation() == ' ' && (to.first == 0 || to.first == 7);
+}
+
 BasicMove::BasicMove(Position from, Position to, Piece *moved) : from_(from),
                      to_(to), moved_(moved) {
    assert(moved);
 }
 
 void BasicMove::perform(Board *b) const {
+    Piece *target;
+    b->saveState(from_, to_, moved_, b->getPiece(to_, &target));
     b->setPiece(to_, moved_);
     moved_->setPosition(to_);
     b->removePiece(from_);
@@ -18,6 +25,7 @@ void BasicMove::unPerform(Board *b) const {
     b->setPiece(from_, moved_);
     moved_->setPosition(from_);
     b->removePiece(to_);
+    b->restoreState();
 }
 
 bool BasicMove::doesCapture(Piece*) const {
@@ -54,6 +62,18 @@ Position BasicMove::getPosition_promotion() const {
     return to_;
 }
 
+Position BasicMove::getFrom() const {
+    return from_;
+}
+
+Position BasicMove::getTo() const {
+    return to_;
+}
+
+Piece *BasicMove::getMoved() const {
+    return moved_;
+}
+
 bool BasicMoveWithCapture::doesCapture(Piece *p) const {
     return (p == NULL) || (p == captured_);
 }
@@ -88,16 +108,27 @@ Position BasicMoveWithCapture::getPosition_promotion() const {
     return BasicMove::getPosition_promotion();
 }
 
+EnPassant::EnPassant(Position from, Position to, Piece *moved, Piece *captured) :
+    BasicMoveWithCapture(from, to, moved, captured) { }
+
+void EnPassant::perform(Board *b) const {
+    BasicMoveWithCapture::perform(b);
+    // the pawn taken is not on the destination square
+    b->removePiece(captured_->getPosition());
+}
+
 Castling::Castling(Piece *moved_k, Piece *moved_r) : moved_k_(moved_k), moved_r_(moved_r) {
 
       assert(moved_k);
       assert(moved_r);
+      king_side_ = moved_r->getPosition().second == 7;
     }
 
 void Castling::perform(Board *b) const {
+    b->saveState(getFrom(), getTo(), moved_k_, false);
     Position pos_k_ = moved_k_->getPosition();
     Position pos_r_ = moved_r_->getPosition();
-    int dir = ((pos_r_.second - pos_k_.second) < 0)? -1 : 1;
+    int dir = ((int) pos_r_.second < (int) pos_k_.second)? -1 : 1;
     b->setPiece({pos_k_.first, pos_k_.second + 2*dir}, moved_k_);
     moved_k_->setPosition({pos_k_.first, pos_k_.second + 2*dir});
     b->removePiece(pos_k_);
@@ -110,7 +141,7 @@ void Castling::perform(Board *b) const {
 void Castling::unPerform(Board *b) const {
     Position pos_k_ = moved_k_->getPosition();
     Position pos_r_ = moved_r_->getPosition();
-    int dir = ((pos_r_.second - pos_k_.second) < 0)? -1 : 1;
+    int dir = ((int) pos_r_.second < (int) pos_k_.second)? -1 : 1;
     int pos_r_new = (pos_r_.second == 3)? 0 : 7;
     b->setPiece({pos_k_.first, 4}, moved_k_);
     moved_k_->setPosition({pos_k_.first, pos_k_.second + 2*dir});
@@ -118,6 +149,7 @@ void Castling::unPerform(Board *b) const {
     b->setPiece({pos_k_.first, pos_r_new}, moved_r_);
     moved_r_->setPosition({pos_k_.first, pos_r_new});
     b->removePiece(pos_r_);
+    b->restoreState();
 }
 
 std::string Castling::toAlgebraicNotation(int i) const {
@@ -126,8 +158,7 @@ std::string Castling::toAlgebraicNotation(int i) const {
 
 std::string Castling::toBasicNotation() const {
     std::string res;
-    Position pos_r_ = moved_r_->getPosition();
-    if (pos_r_.second == 0) {
+    if (!king_side_) {
       res = "O-O-O";
     } else {
       res = "O-O";
@@ -143,3 +174,17 @@ Position Castling::getPosition_promotion() const {
     Position pos;
     return pos;
 }
+
+Position Castling::getFrom() const {
+    unsigned int line = (moved_k_->getColor() == WHITE) ? 0 : 7;
+    return {line, 4};
+}
+
+Position Castling::getTo() const {
+    unsigned int line = (moved_k_->getColor() == WHITE) ? 0 : 7;
+    return {line, king_side_ ? 6u : 2u};
+}
+
+Piece *Castling::getMoved() const {
+    return moved_k_;
+}
@@ -1,6 +1,6 @@
 // This module defines the virtual class Move and its subclasses BasicMove
-// BasicMoveWithCapture. New subclasses can be added here, such as KingCastling, QueenCastling,
-// or PawnPromotion
+// BasicMoveWithCapture, EnPassant and Castling. New subclasses can be added
+// here, such as PawnPromotion
 
 #ifndef MOVE_H_
 #define MOVE_H_
@@ -26,10 +26,13 @@ class Board;
 class Move {
 public:
 
+    virtual ~Move() {}
+
     // Modify b by performing the move. The move object must have been computed
     // on this instance of b.
     //
-    // The attributes (position, capture state) of the pieces involved are updated
+    // The attributes (position, capture state) of the pieces involved are
+    // updated, and the state of b is saved (see Board::saveState())
     virtual void perform(Board *b) const = 0;
 
     // Modify b by unperforming the move. This move must have been performed just
@@ -56,6 +59,21 @@ public:
     //Returns the to_ position  of the move in question
     virtual Position getPosition_promotion() const = 0;
 
+    // returns the starting position of the moved piece (the king's for a
+    // castling)
+    virtual Position getFrom() const = 0;
+
+    // returns the final position of the moved piece (the king's for a
+    // castling)
+    virtual Position getTo() const = 0;
+
+    // returns the moved piece (the king for a castling)
+    virtual Piece *getMoved() const = 0;
+
+    // returns true if the move brings a pawn to the last line, where it must
+    // be promoted
+    bool isPromotion() const;
+
 
 protected:
     Color player_;
@@ -80,6 +98,12 @@ public:
 
   virtual Position getPosition_promotion() const;
 
+  Position getFrom() const;
+
+  Position getTo() const;
+
+  Piece *getMoved() const;
+
 
 private:
   Position from_;
@@ -103,10 +127,20 @@ public:
 
     virtual Position getPosition_promotion() const;
 
-private:
+protected:
     Piece *captured_;
 };
 
+// A pawn takes the pawn that has just advanced two squares next to it, by
+// moving to the square that pawn crossed.
+class EnPassant : public BasicMoveWithCapture {
+
+public:
+    EnPassant(Position from, Position to, Piece *moved, Piece *captured);
+
+    void perform(Board *b) const;
+};
+
 
 class Castling : public Move {
 
@@ -125,11 +159,20 @@ public:
 
     virtual Position getPosition_promotion() const;
 
+    Position getFrom() const;
+
+    Position getTo() const;
+
+    Piece *getMoved() const;
+
 
 private:
 
     Piece *moved_k_;
     Piece *moved_r_;
+    // the rook's position changes when the move is performed, so the side is
+    // remembered at construction
+    bool king_side_;
 
 };
 
@@ -0,0 +1,198 @@
+#include "movegen.h"
+#include "bitboard.h"
+
+// push_back's on res the move of the piece on square from to square to,
+// taking the piece there if any
+static void addMove(const Board &b, int from, int to, MoveList &res) {
+    Piece *captured = b.pieceAt(to);
+    if (captured == NULL) {
+        res.push_back(new BasicMove(squarePosition(from), squarePosition(to), b.pieceAt(from)));
+    } else {
+        res.push_back(new BasicMoveWithCapture(squarePosition(from), squarePosition(to),
+                                               b.pieceAt(from), captured));
+    }
+}
+
+// push_back's on res the moves to the squares of tos of the pawns that stand
+// at offset -delta from them
+static void addPawnMoves(const Board &b, Bitboard tos, int delta, MoveList &res) {
+    while (tos) {
+        int to = popLsb(tos);
+        addMove(b, to - delta, to, res);
+    }
+}
+
+// push_back's on res the moves of kind G (CAPTURES, QUIETS or ALL) of the
+// pawns of player Us that stand on the squares of pawns, and that go to the
+// squares of target. An en passant capture is kept if the square of the
+// taken pawn is in target.
+template <Color Us, GenType G>
+static void generatePawnMoves(const Board &b, Bitboard pawns, Bitboard target,
+                              MoveList &res) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    constexpr Direction Up = (Us == WHITE) ? NORTH : SOUTH;
+    constexpr Direction UpEast = (Us == WHITE) ? NORTH_EAST : SOUTH_EAST;
+    constexpr Direction UpWest = (Us == WHITE) ? NORTH_WEST : SOUTH_WEST;
+    // the pawns that promote as they move, and the squares reached by a
+    // first push, from which a second push is possible
+    constexpr Bitboard Rank7 = (Us == WHITE) ? RANK_7 : RANK_2;
+    constexpr Bitboard Rank3 = (Us == WHITE) ? RANK_3 : RANK_6;
+    Bitboard empty = ~b.occupancy();
+    Bitboard enemies = b.occupancy(Them);
+    Bitboard promoting = pawns & Rank7;
+    Bitboard others = pawns & ~Rank7;
+
+    if constexpr (G != QUIETS) {
+        addPawnMoves(b, shift<UpEast>(pawns) & enemies & target, UpEast, res);
+        addPawnMoves(b, shift<UpWest>(pawns) & enemies & target, UpWest, res);
+        addPawnMoves(b, shift<Up>(promoting) & empty & target, Up, res);
+        // the en passant square is that of the player to move
+        Position ep;
+        if (b.getPlayer() == Us && b.enPassant(&ep)) {
+            int to = square(ep);
+            if (target & (squareBit(to) | squareBit(to - Up))) {
+                Bitboard takers = pawns & pawnAttacks(Them, to);
+                Piece *taken = b.pieceAt(to - Up);
+                while (takers) {
+                    int from = popLsb(takers);
+                    res.push_back(new EnPassant(squarePosition(from), ep, b.pieceAt(from), taken));
+                }
+            }
+        }
+    }
+    if constexpr (G != CAPTURES) {
+        Bitboard push = shift<Up>(others) & empty;
+        Bitboard push2 = shift<Up>(push & Rank3) & empty;
+        addPawnMoves(b, push & target, Up, res);
+        addPawnMoves(b, push2 & target, 2 * Up, res);
+    }
+}
+
+// push_back's on res the moves of the pieces of type T of player Us to the
+// squares of target
+template <Color Us, PieceType T>
+static void generatePieceMoves(const Board &b, Bitboard target, MoveList &res) {
+    Bitboard occupied = b.occupancy();
+    Bitboard pieces = b.pieces(pieceCode(T, Us));
+    while (pieces) {
+        int from = popLsb(pieces);
+        Bitboard tos = attacks<T>(from, occupied) & target;
+        while (tos) {
+            addMove(b, from, popLsb(tos), res);
+        }
+    }
+}
+
+// the moves of the pieces other than the pawns to the squares of target
+template <Color Us>
+static void generateNonPawnMoves(const Board &b, Bitboard target, MoveList &res) {
+    generatePieceMoves<Us, KNIGHT>(b, target, res);
+    generatePieceMoves<Us, BISHOP>(b, target, res);
+    generatePieceMoves<Us, ROOK>(b, target, res);
+    generatePieceMoves<Us, QUEEN>(b, target, res);
+    generatePieceMoves<Us, KING>(b, target, res);
+}
+
+template <Color Us, GenType G>
+void generate(const Board &b, MoveList &res) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    Bitboard pawns = b.pieces(pieceCode(PAWN, Us));
+    if constexpr (G == EVASIONS) {
+        int king = lsb(b.pieces(pieceCode(KING, Us)));
+        Bitboard checkers = b.attackers(king, Them);
+        if (checkers == 0) {
+            generate<Us, ALL>(b, res);
+            return;
+        }
+        generatePieceMoves<Us, KING>(b, ~b.occupancy(Us), res);
+        // in double check, only the king can move
+        if (checkers & (checkers - 1)) {
+            return;
+        }
+        int checker = lsb(checkers);
+        Bitboard target = between(king, checker) | squareBit(checker);
+        generatePawnMoves<Us, ALL>(b, pawns, target, res);
+        generatePieceMoves<Us, KNIGHT>(b, target, res);
+        generatePieceMoves<Us, BISHOP>(b, target, res);
+        generatePieceMoves<Us, ROOK>(b, target, res);
+        generatePieceMoves<Us, QUEEN>(b, target, res);
+    } else {
+        Bitboard target = (G == CAPTURES) ? b.occupancy(Them) :
+                          (G == QUIETS) ? ~b.occupancy() : ~b.occupancy(Us);
+        generatePawnMoves<Us, G>(b, pawns, ~0ULL, res);
+        generateNonPawnMoves<Us>(b, target, res);
+    }
+}
+
+template void generate<WHITE, CAPTURES>(const Board &, MoveList &);
+template void generate<WHITE, QUIETS>(const Board &, MoveList &);
+template void generate<WHITE, EVASIONS>(const Board &, MoveList &);
+template void generate<WHITE, ALL>(const Board &, MoveList &);
+template void generate<BLACK, CAPTURES>(const Board &, MoveList &);
+template void generate<BLACK, QUIETS>(const Board &, MoveList &);
+template void generate<BLACK, EVASIONS>(const Board &, MoveList &);
+template void generate<BLACK, ALL>(const Board &, MoveList &);
+
+template <Color Us>
+static void generateMoves(const Board &b, GenType type, MoveList &res) {
+    switch (type) {
+      case CAPTURES:
+        generate<Us, CAPTURES>(b, res);
+        break;
+      case QUIETS:
+        generate<Us, QUIETS>(b, res);
+        break;
+      case EVASIONS:
+        generate<Us, EVASIONS>(b, res);
+        break;
+      case ALL:
+        generate<Us, ALL>(b, res);
+        break;
+    }
+}
+
+void generateMoves(const Board &b, Color c, GenType type, MoveList &res) {
+    if (c == WHITE) {
+        generateMoves<WHITE>(b, type, res);
+    } else {
+        generateMoves<BLACK>(b, type, res);
+    }
+}
+
+// the moves of the piece of type T on square from, of player c
+template <PieceType T>
+static void generateSquareMoves(const Board &b, int from, Color c, MoveList &res) {
+    Bitboard tos = attacks<T>(from, b.occupancy()) & ~b.occupancy(c);
+    while (tos) {
+        addMove(b, from, popLsb(tos), res);
+    }
+}
+
+void generatePieceMoves(const Board &b, const Piece &p, MoveList &res) {
+    int from = square(p.getPosition());
+    Color c = p.getColor();
+    switch (p.type()) {
+      case PAWN:
+        if (c == WHITE) {
+            generatePawnMoves<WHITE, ALL>(b, squareBit(from), ~0ULL, res);
+        } else {
+            generatePawnMoves<BLACK, ALL>(b, squareBit(from), ~0ULL, res);
+        }
+        break;
+      case KNIGHT:
+        generateSquareMoves<KNIGHT>(b, from, c, res);
+        break;
+      case BISHOP:
+        generateSquareMoves<BISHOP>(b, from, c, res);
+        break;
+      case ROOK:
+        generateSquareMoves<ROOK>(b, from, c, res);
+        break;
+      case QUEEN:
+        generateSquareMoves<QUEEN>(b, from, c, res);
+        break;
+      case KING:
+        generateSquareMoves<KING>(b, from, c, res);
+        break;
+    }
+}
@@ -0,0 +1,45 @@
+// The move generators, computed on the bitboards of the Board (see
+// bitboard.h). The generators are templated on the player to move and the
+// kind of moves (see GenType), so that the directions of the pawns, their
+// promotion rank and the squares they may go to are constants of each
+// instance. The pawns are moved all at once: the single pushes, the double
+// pushes and the captures of each side are each computed by one shift of
+// the bitboard of the pawns.
+//
+// The moves are pseudo-legal: they may leave the king of the player in
+// check, see Board::getAllLegalMoves(). A promotion is a single move of the
+// pawn to the last rank, the new piece being chosen when it is played. The
+// castlings are left to Board::getAllLegalMoves().
+
+#ifndef MOVEGEN_H_
+#define MOVEGEN_H_
+
+#include <vector>
+#include "global.h"
+#include "board.h"
+#include "piece.h"
+#include "move.h"
+
+// push_back's on res the moves of kind G of player Us, whose turn it is, on
+// b. The EVASIONS are meant for when Us is in check: the moves of the king,
+// and, if a single piece gives check, the moves that take it or that go
+// between it and the king; when Us is not in check, they are ALL the moves.
+template <Color Us, GenType G>
+void generate(const Board &b, MoveList &res);
+
+// generate<c, type>(b, res)
+void generateMoves(const Board &b, Color c, GenType type, MoveList &res);
+
+// push_back's on res all the possible moves of p on b, see Piece::getMoves()
+void generatePieceMoves(const Board &b, const Piece &p, MoveList &res);
+
+extern template void generate<WHITE, CAPTURES>(const Board &, MoveList &);
+extern template void generate<WHITE, QUIETS>(const Board &, MoveList &);
+extern template void generate<WHITE, EVASIONS>(const Board &, MoveList &);
+extern template void generate<WHITE, ALL>(const Board &, MoveList &);
+extern template void generate<BLACK, CAPTURES>(const Board &, MoveList &);
+extern template void generate<BLACK, QUIETS>(const Board &, MoveList &);
+extern template void generate<BLACK, EVASIONS>(const Board &, MoveList &);
+extern template void generate<BLACK, ALL>(const Board &, MoveList &);
+
+#endif // MOVEGEN_H_
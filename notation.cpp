@@ -0,0 +1,391 @@
+#include <string>
+#include <cstring>
+#include <cctype>
+#include "notation.h"
+#include "board.h"
+#include "move.h"
+#include "piece.h"
+#include "global.h"
+
+// returns true if pawn p of player pl can move straight (without capture) to
+// position to
+static bool pawnCanPush(const Board &b, Piece *p, Position to, Color pl) {
+    int di = (pl == WHITE) ? 1 : -1;
+    int start = (pl == WHITE) ? 1 : 6;
+    Position from = p->getPosition();
+    Piece *q;
+    if (from.second != to.second || b.getPiece(to, &q)) {
+        return false;
+    }
+    if ((int) from.first + di == (int) to.first) {
+        return true;
+    }
+    return (int) from.first == start && (int) from.first + 2*di == (int) to.first &&
+           !b.getPiece({from.first + di, from.second}, &q);
+}
+
+// stores in res the pawn of player pl that can push to position to, and
+// returns 1, or returns 0 if there is none
+static int pawnPushersTo(const Board &b, Position to, Color pl, Piece *res[8]) {
+    int di = (pl == WHITE) ? -1 : 1;
+    for (int steps = 1; steps <= 2; steps++) {
+        int i = (int) to.first + steps*di;
+        if (i < 0 || i > 7) {
+            return 0;
+        }
+        Piece *p;
+        if (b.getPiece({i, to.second}, &p)) {
+            if (p->getColor() == pl && p->notation() == ' ' && pawnCanPush(b, p, to, pl)) {
+                res[0] = p;
+                return 1;
+            }
+            return 0;
+        }
+    }
+    return 0;
+}
+
+static Move *parseCastling(Board &b, bool king_side) {
+    Color pl = b.getPlayer();
+    unsigned int line = (pl == WHITE) ? 0 : 7;
+    Piece *k;
+    Piece *r;
+    b.getPiece({line, 4}, &k);
+    b.getPiece({line, king_side ? 7u : 0u}, &r);
+    if (!b.castling_permitted(k, r, king_side ? 2 : 3, line)) {
+        return NULL;
+    }
+    return new Castling(k, r);
+}
+
+Move *parseMove(Board &b, const std::string &san, char *promotion) {
+    *promotion = ' ';
+    size_t len = san.size();
+    // check, mate and annotation suffixes carry no information for us
+    while (len > 0 && strchr("+#!?", san[len-1]) != NULL) {
+        len--;
+    }
+    std::string s = san.substr(0, len);
+    if (s == "O-O" || s == "0-0") {
+        return parseCastling(b, true);
+    }
+    if (s == "O-O-O" || s == "0-0-0") {
+        return parseCastling(b, false);
+    }
+
+    // promotion: "e8=Q", "e8Q" or "e7e8q"
+    if (len >= 3 && s[len-2] == '=') {
+        *promotion = s[len-1];
+        len -= 2;
+    } else if (len >= 3 && s[len-2] >= '1' && s[len-2] <= '8' &&
+               strchr("QRBNqrbn", s[len-1]) != NULL) {
+        *promotion = s[len-1];
+        len -= 1;
+    }
+    if (*promotion != ' ') {
+        *promotion = toupper(*promotion);
+        if (strchr("QRBN", *promotion) == NULL) {
+            return NULL;
+        }
+    }
+
+    // piece letter, and the remaining characters without 'x' and '-'
+    size_t k = 0;
+    char n = ' ';
+    if (len > 0 && strchr("KQRBN", s[0]) != NULL) {
+        n = s[0];
+        k = 1;
+    }
+    bool capture = false;
+    char rest[8];
+    size_t nrest = 0;
+    for (; k < len; k++) {
+        if (s[k] == 'x') {
+            capture = true;
+        } else if (s[k] != '-') {
+            if (nrest == sizeof(rest)) {
+                return NULL;
+            }
+            rest[nrest++] = s[k];
+        }
+    }
+    if (nrest < 2 || nrest > 4) {
+        return NULL;
+    }
+
+    // destination, then the optional file and rank of the starting position
+    char to_file = rest[nrest-2];
+    char to_rank = rest[nrest-1];
+    if (to_file < 'a' || to_file > 'h' || to_rank < '1' || to_rank > '8') {
+        return NULL;
+    }
+    Position to = {(unsigned int) (to_rank - '1'), (unsigned int) (to_file - 'a')};
+    int from_file = -1;
+    int from_rank = -1;
+    for (size_t i = 0; i + 2 < nrest; i++) {
+        if (rest[i] >= 'a' && rest[i] <= 'h' && from_file == -1 && from_rank == -1) {
+            from_file = rest[i] - 'a';
+        } else if (rest[i] >= '1' && rest[i] <= '8' && from_rank == -1) {
+            from_rank = rest[i] - '1';
+        } else {
+            return NULL;
+        }
+    }
+
+    Color pl = b.getPlayer();
+    Piece *target;
+    bool occupied = b.getPiece(to, &target);
+    if (occupied && target->getColor() == pl) {
+        return NULL;
+    }
+
+    Piece *candidates[8];
+    int ncandidates;
+    if (from_file != -1 && from_rank != -1) {
+        // long algebraic notation: the piece is the one on the starting square
+        Piece *p;
+        if (!b.getPiece({(unsigned int) from_rank, (unsigned int) from_file}, &p) ||
+            p->getColor() != pl || (n != ' ' && p->notation() != n)) {
+            return NULL;
+        }
+        n = p->notation();
+        unsigned int line = (pl == WHITE) ? 0 : 7;
+        if (n == 'K' && from_file == 4 && to.first == line && from_rank == (int) line &&
+            (to.second == 6 || to.second == 2)) {
+            return parseCastling(b, to.second == 6);
+        }
+    }
+
+    // en passant: a pawn takes, or moves to another file, towards the en
+    // passant square. The pawn taken is behind it.
+    Position ep;
+    bool en_passant = n == ' ' && !occupied && b.enPassant(&ep) && ep == to &&
+                      (capture || (from_file != -1 && from_file != (int) to.second));
+    if (en_passant) {
+        b.getPiece({(pl == WHITE) ? to.first - 1 : to.first + 1, to.second}, &target);
+    } else if (capture && !occupied) {
+        return NULL;
+    }
+    if (n == ' ' && !occupied && !en_passant) {
+        ncandidates = pawnPushersTo(b, to, pl, candidates);
+    } else {
+        ncandidates = b.attackersTo(to, pl, n, candidates);
+    }
+
+    // a promotion is only valid, and only read, for a pawn reaching the last
+    // line, which must be promoted
+    unsigned int last_line = (pl == WHITE) ? 7 : 0;
+    if (*promotion != ' ' && (n != ' ' || to.first != last_line)) {
+        return NULL;
+    }
+    if (n == ' ' && to.first == last_line && *promotion == ' ') {
+        return NULL;
+    }
+
+    Piece *moved = NULL;
+    for (int c = 0; c < ncandidates; c++) {
+        Piece *p = candidates[c];
+        Position from = p->getPosition();
+        if ((from_file != -1 && (int) from.second != from_file) ||
+            (from_rank != -1 && (int) from.first != from_rank)) {
+            continue;
+        }
+        bool legal;
+        if (en_passant) {
+            EnPassant m(from, to, p, target);
+            legal = b.isLegal(&m);
+        } else if (occupied) {
+            BasicMoveWithCapture m(from, to, p, target);
+            legal = b.isLegal(&m);
+        } else {
+            BasicMove m(from, to, p);
+            legal = b.isLegal(&m);
+        }
+        if (!legal) {
+            continue;
+        }
+        if (moved != NULL) {
+            // ambiguous, the disambiguator is missing
+            return NULL;
+        }
+        moved = p;
+    }
+    if (moved == NULL) {
+        return NULL;
+    }
+    if (en_passant) {
+        return new EnPassant(moved->getPosition(), to, moved, target);
+    }
+    if (occupied) {
+        return new BasicMoveWithCapture(moved->getPosition(), to, moved, target);
+    }
+    return new BasicMove(moved->getPosition(), to, moved);
+}
+
+int writeSAN(Board &b, Move *m, char promotion, char *buf) {
+    int len = 0;
+    Piece *moved = m->getMoved();
+    Position from = m->getFrom();
+    Position to = m->getTo();
+    char n = moved->notation();
+    int file_distance = (int) to.second - (int) from.second;
+    if (n == 'K' && (file_distance == 2 || file_distance == -2)) {
+        // castling: the king travels two squares
+        const char *castling = (to.second == 6) ? "O-O" : "O-O-O";
+        while (*castling != '\0') {
+            buf[len++] = *castling++;
+        }
+    } else {
+        bool capture = m->doesCapture(NULL);
+        if (n != ' ') {
+            buf[len++] = n;
+            // the other pieces of the same type that can legally go to `to`
+            Piece *others[8];
+            int nothers = b.attackersTo(to, moved->getColor(), n, others);
+            bool ambiguous = false;
+            bool same_file = false;
+            bool same_rank = false;
+            Piece *target;
+            b.getPiece(to, &target);
+            for (int i = 0; i < nothers; i++) {
+                Position o = others[i]->getPosition();
+                if (others[i] == moved) {
+                    continue;
+                }
+                bool legal;
+                if (target != NULL) {
+                    BasicMoveWithCapture om(o, to, others[i], target);
+                    legal = b.isLegal(&om);
+                } else {
+                    BasicMove om(o, to, others[i]);
+                    legal = b.isLegal(&om);
+                }
+                if (!legal) {
+                    continue;
+                }
+                ambiguous = true;
+                same_file = same_file || o.second == from.second;
+                same_rank = same_rank || o.first == from.first;
+            }
+            if (ambiguous && (!same_file || same_rank)) {
+                buf[len++] = getFileLetter(from);
+            }
+            if (ambiguous && same_file) {
+                buf[len++] = getRank(from);
+            }
+        } else if (capture) {
+            buf[len++] = getFileLetter(from);
+        }
+        if (capture) {
+            buf[len++] = 'x';
+        }
+        buf[len++] = getFileLetter(to);
+        buf[len++] = getRank(to);
+        if (promotion != ' ') {
+            buf[len++] = '=';
+            buf[len++] = promotion;
+        }
+    }
+
+    m->perform(&b);
+    b.switch_player();
+    // the promoted piece is only needed while the suffix is computed, it
+    // stands on the board in place of the pawn
+    Color pl = moved->getColor();
+    Piece queen(to, pl, QUEEN);
+    Piece rook(to, pl, ROOK);
+    Piece bishop(to, pl, BISHOP);
+    Piece knight(to, pl, KNIGHT);
+    Piece *promoted = (promotion == 'Q') ? (Piece *) &queen :
+                      (promotion == 'R') ? (Piece *) &rook :
+                      (promotion == 'B') ? (Piece *) &bishop :
+                      (promotion == 'N') ? (Piece *) &knight : NULL;
+    if (promoted != NULL) {
+        b.setPiece(to, promoted);
+    }
+    if (b.isInCheck(b.getPlayer())) {
+        buf[len++] = b.hasLegalMove() ? '+' : '#';
+    }
+    if (promoted != NULL) {
+        b.setPiece(to, moved);
+    }
+    b.switch_player();
+    m->unPerform(&b);
+    buf[len] = '\0';
+    return len;
+}
+
+std::string toSAN(Board &b, Move *m, char promotion) {
+    char buf[MAX_SAN_LENGTH];
+    writeSAN(b, m, promotion, buf);
+    return buf;
+}
+
+std::string toLAN(const Move *m, char promotion) {
+    std::string lan = getFileRank(m->getFrom()) + getFileRank(m->getTo());
+    if (promotion != ' ') {
+        lan += (char) tolower(promotion);
+    }
+    return lan;
+}
+
+// appends the SAN of m to buf if it fits in size, preceded by a space unless
+// it is the first one. A promotion is to a queen. Returns false if it
+// doesn't fit.
+static bool appendSAN(Board &b, Move *m, char *buf, size_t size, size_t *len) {
+    char san[MAX_SAN_LENGTH];
+    int n = writeSAN(b, m, m->isPromotion() ? 'Q' : ' ', san);
+    size_t sep = (*len == 0) ? 0 : 1;
+    if (*len + sep + n + 1 > size) {
+        return false;
+    }
+    if (sep) {
+        buf[(*len)++] = ' ';
+    }
+    memcpy(buf + *len, san, n + 1);
+    *len += n;
+    return true;
+}
+
+size_t writeSANList(Board &b, const std::vector<Move *> &moves,
+                    char *buf, size_t size) {
+    size_t len = 0;
+    if (size > 0) {
+        buf[0] = '\0';
+    }
+    for (auto m : moves) {
+        if (!appendSAN(b, m, buf, size, &len)) {
+            break;
+        }
+    }
+    return len;
+}
+
+size_t writeSANLine(Board &b, const std::vector<Move *> &line,
+                    char *buf, size_t size) {
+    size_t len = 0;
+    size_t played = 0;
+    if (size > 0) {
+        buf[0] = '\0';
+    }
+    for (auto m : line) {
+        if (!appendSAN(b, m, buf, size, &len)) {
+            break;
+        }
+        m->perform(&b);
+        b.switch_player();
+        if (m->isPromotion()) {
+            b.promote_pawn_b(m, "Q");
+        }
+        played++;
+    }
+    while (played > 0) {
+        Move *m = line[--played];
+        if (m->isPromotion()) {
+            b.unpromote_pawn_b(m);
+        }
+        b.switch_player();
+        m->unPerform(&b);
+    }
+    return len;
+}
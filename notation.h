@@ -0,0 +1,68 @@
+// This module converts text typed by the user or read from a PGN file into
+// moves, and moves back into text. Both the standard algebraic notation (SAN)
+// and the long algebraic notation (LAN) are understood, e.g.
+//
+//   e4  exd5  xd5  Nbd7  R1e2  Qh4xe1  e8=Q  e8Q  Rd3+  Qf7#  O-O  0-0-0
+//   e2e4  e2-e4  Ng1f3  e7e8q  e1g1
+//
+// The text is decoded directly: the piece, destination, disambiguator, capture
+// and promotion are read from the string, and the moving piece is found by
+// looking backwards from the destination square (see Board::attackersTo()).
+// No move list is generated and no string is built.
+//
+// The other way around, the SAN of a move is written in constant time: the
+// other pieces of the same type that could reach the destination are found
+// with the same backwards lookup, and decide the disambiguator.
+
+#ifndef NOTATION_H_
+#define NOTATION_H_
+
+#include <string>
+#include <vector>
+#include "board.h"
+#include "move.h"
+
+// returns the legal move described by san on board b, or NULL if san is not
+// a legal move (or is ambiguous).
+// If the move promotes a pawn, *promotion receives the letter of the new piece
+// ('Q', 'R', 'B' or 'N'), otherwise it receives ' '. A pawn move to the last
+// line without the letter of the new piece is not a legal move.
+// Check and mate suffixes ('+', '#') and annotations ('!', '?') are ignored.
+Move *parseMove(Board &b, const std::string &san, char *promotion);
+
+// longest SAN written by writeSAN(), e.g. "Qh4xe1+" or "exd8=Q#", with the
+// terminating '\0'
+const int MAX_SAN_LENGTH = 8;
+
+// writes in buf the SAN of the legal move m of board b, followed by '\0', and
+// returns its length. promotion is the letter of the piece a pawn is
+// promoted to, or ' '. buf must hold MAX_SAN_LENGTH chars.
+// The move is performed and unperformed to find the check ('+') and mate ('#')
+// suffixes, b is left as it was found. The mate is told by
+// Board::hasLegalMove(), which creates no move.
+int writeSAN(Board &b, Move *m, char promotion, char *buf);
+
+std::string toSAN(Board &b, Move *m, char promotion);
+
+// returns the LAN of m as written by the UCI protocol: the squares, then the
+// promotion letter in lowercase, e.g. "e2e4", "e1g1" (castling), "e7e8q".
+// Unlike the SAN, it doesn't need the board.
+std::string toLAN(const Move *m, char promotion);
+
+// writes in buf the SAN of the legal moves of board b, separated by spaces
+// and followed by '\0', the promotions being to a queen (e.g. "e8=Q", as
+// toSAN(b, m, 'Q')). At most size chars are written, the list is cut
+// before the first move that doesn't fit. Returns the length written.
+// Nothing is allocated, so a move list can be formatted in a buffer on
+// the stack.
+size_t writeSANList(Board &b, const std::vector<Move *> &moves,
+                    char *buf, size_t size);
+
+// same as writeSANList(), but moves is a line (e.g. a principal variation):
+// each move is performed before the next one is written, the pawns being
+// promoted to queens as in the search (the queens being made in the arena of
+// the pieces of b, see Board::promote_pawn_b()). b is left as it was found.
+size_t writeSANLine(Board &b, const std::vector<Move *> &line,
+                    char *buf, size_t size);
+
+#endif // NOTATION_H_
@@ -0,0 +1,93 @@
+#include "perft.h"
+#include "move.h"
+#include "notation.h"
+
+static const char PROMOTIONS[] = "QRBN";
+
+// plays m on b, with the promotion to promotion if m is a promotion
+static void play(Board &b, Move *m, char promotion) {
+    m->perform(&b);
+    b.switch_player();
+    if (promotion != ' ') {
+        b.promote_pawn_b(m, std::string(1, promotion));
+    }
+}
+
+static void unplay(Board &b, Move *m, char promotion) {
+    if (promotion != ' ') {
+        b.unpromote_pawn_b(m);
+    }
+    b.switch_player();
+    m->unPerform(&b);
+}
+
+// the pieces m can promote to, " " if it is not a promotion
+static const char *promotions(const Move *m) {
+    return m->isPromotion() ? PROMOTIONS : " ";
+}
+
+uint64_t perft(Board &b, int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    std::vector<Move *> moves = b.getAllLegalMoves();
+    uint64_t leaves = 0;
+    for (auto m : moves) {
+        for (const char *p = promotions(m); *p != '\0'; p++) {
+            if (depth == 1) {
+                // the leaves are counted without being played
+                leaves++;
+                continue;
+            }
+            play(b, m, *p);
+            leaves += perft(b, depth - 1);
+            unplay(b, m, *p);
+        }
+        delete m;
+    }
+    return leaves;
+}
+
+uint64_t parallelPerft(ThreadPool &pool, const std::string &fen, int depth,
+                       std::vector<std::pair<std::string, uint64_t> > *divide) {
+    Board root;
+    if (!root.fromFEN(fen)) {
+        return 0;
+    }
+    if (depth <= 0) {
+        return 1;
+    }
+    // a task per move of the root and promotion. The moves are generated in
+    // the same order on the board of each worker.
+    std::vector<std::pair<size_t, char> > tasks;
+    std::vector<std::string> names;
+    std::vector<Move *> root_moves = root.getAllLegalMoves();
+    for (size_t k = 0; k < root_moves.size(); k++) {
+        for (const char *p = promotions(root_moves[k]); *p != '\0'; p++) {
+            tasks.push_back({k, *p});
+            names.push_back(toSAN(root, root_moves[k], *p));
+        }
+        delete root_moves[k];
+    }
+    std::vector<uint64_t> leaves(tasks.size());
+    std::vector<Board> boards(pool.size());
+    parallelFor(pool, tasks.size(), [&](size_t i, int worker) {
+        Board &b = boards[worker];
+        b.fromFEN(fen);
+        std::vector<Move *> legal = b.getAllLegalMoves();
+        Move *m = legal[tasks[i].first];
+        play(b, m, tasks[i].second);
+        leaves[i] = perft(b, depth - 1);
+        for (auto lm : legal) {
+            delete lm;
+        }
+    });
+    uint64_t total = 0;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        total += leaves[i];
+        if (divide != NULL) {
+            divide->push_back({names[i], leaves[i]});
+        }
+    }
+    return total;
+}
@@ -0,0 +1,30 @@
+// This module counts the leaves of the tree of legal moves to a given depth
+// ("perft"), to check the move generation against the known counts and to
+// measure its speed.
+// see https://www.chessprogramming.org/Perft_Results
+//
+// A promotion counts for four moves, one per piece the pawn can become.
+
+#ifndef PERFT_H_
+#define PERFT_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "board.h"
+#include "threadpool.h"
+
+// returns the number of leaves of the tree of depth depth from b. b is left
+// as it was found.
+uint64_t perft(Board &b, int depth);
+
+// same as perft() for the position fen (see Board::fromFEN()), the subtrees
+// of the moves of the root being counted in parallel on the workers of pool.
+// If divide is not NULL, it receives the SAN of each move of the root and the
+// leaves of its subtree.
+// returns 0 if fen is not valid.
+uint64_t parallelPerft(ThreadPool &pool, const std::string &fen, int depth,
+                       std::vector<std::pair<std::string, uint64_t> > *divide);
+
+#endif // PERFT_H_
@@ -0,0 +1,123 @@
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cctype>
+#include "pgn.h"
+
+std::string PgnGame::tag(const std::string &name) const {
+    for (const auto &t : tags) {
+        if (t.first == name) {
+            return t.second;
+        }
+    }
+    return "";
+}
+
+static bool isResult(const std::string &token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+// parses a tag pair line, e.g. [Event "Wch U10"]
+static void parseTag(const std::string &line, PgnGame &g) {
+    size_t name_end = line.find(' ');
+    size_t open = line.find('"');
+    size_t close = line.rfind('"');
+    if (name_end == std::string::npos || open == std::string::npos || close <= open) {
+        return;
+    }
+    g.tags.push_back({line.substr(1, name_end - 1),
+                      line.substr(open + 1, close - open - 1)});
+}
+
+// adds the token found in the movetext to g, once the move number is
+// removed (e.g. "12.Nf3", "12...Nf3" or "12."). Returns true if the token is
+// the result, i.e. the end of the game.
+static bool addToken(const std::string &token, PgnGame &g) {
+    if (isResult(token)) {
+        g.result = token;
+        return true;
+    }
+    size_t k = 0;
+    while (k < token.size() && isdigit(token[k])) {
+        k++;
+    }
+    if (k < token.size() && token[k] == '.') {
+        while (k < token.size() && token[k] == '.') {
+            k++;
+        }
+    } else {
+        k = 0;
+    }
+    if (k < token.size() && token[k] != '$') {
+        g.moves.push_back(token.substr(k));
+    }
+    return false;
+}
+
+bool readPgnGame(std::istream &in, PgnGame &g) {
+    g.tags.clear();
+    g.moves.clear();
+    g.result = "*";
+    std::string line;
+    bool started = false;
+    // the tag pairs, possibly preceded by blank lines
+    while (true) {
+        while (in.peek() != EOF && isspace(in.peek())) {
+            in.get();
+        }
+        if (in.peek() != '[') {
+            break;
+        }
+        getline(in, line);
+        parseTag(line, g);
+        started = true;
+    }
+    // the movetext, until the result or the tags of the next game
+    int comment = 0;
+    int variation = 0;
+    while (in.peek() != EOF) {
+        if (in.peek() == '[' && comment == 0) {
+            break;
+        }
+        getline(in, line);
+        std::string token;
+        bool done = false;
+        for (size_t i = 0; i <= line.size() && !done; i++) {
+            char c = (i < line.size()) ? line[i] : ' ';
+            if (comment > 0) {
+                comment -= (c == '}');
+                continue;
+            }
+            if (c == '{' || c == '(' || c == ')' || c == ';' || isspace(c)) {
+                if (!token.empty() && variation == 0) {
+                    done = addToken(token, g);
+                }
+                token.clear();
+                comment += (c == '{');
+                variation += (c == '(') - (c == ')' && variation > 0);
+                if (c == ';') {
+                    break;
+                }
+                continue;
+            }
+            token += c;
+        }
+        started = started || !g.moves.empty();
+        if (done) {
+            break;
+        }
+    }
+    return started;
+}
+
+bool readPgnFile(const std::string &filename, std::vector<PgnGame> &games) {
+    std::ifstream file(filename);
+    if (!file) {
+        return false;
+    }
+    PgnGame g;
+    while (readPgnGame(file, g)) {
+        games.push_back(g);
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+// This module reads games in the Portable Game Notation (PGN)
+// https://en.wikipedia.org/wiki/Portable_Game_Notation
+//
+// A game is a list of tag pairs, e.g. [White "Akobian, Varuzhan"], followed by
+// the movetext, e.g. 1.e4 e6 2.d4 d5 ... 0-1
+// Move numbers, comments ({...} and ; to the end of line), variations (...)
+// and numeric annotation glyphs ($1) are skipped, so that only the moves in
+// SAN and the result are kept. The moves themselves are not validated here,
+// see notation.h.
+
+#ifndef PGN_H_
+#define PGN_H_
+
+#include <istream>
+#include <string>
+#include <vector>
+#include <utility>
+
+struct PgnGame {
+    // the tag pairs in the order of the file
+    std::vector<std::pair<std::string, std::string> > tags;
+
+    // the moves, e.g. {"e4", "e6", "d4", ...}
+    std::vector<std::string> moves;
+
+    // "1-0", "0-1", "1/2-1/2" or "*" if unknown
+    std::string result;
+
+    // returns the value of the tag name, or "" if the game has no such tag
+    std::string tag(const std::string &name) const;
+};
+
+// reads the next game of in and stores it in g.
+// returns false if there is no game left.
+bool readPgnGame(std::istream &in, PgnGame &g);
+
+// reads all the games of the file filename and push_back's them in games.
+// returns false if the file can't be read.
+bool readPgnFile(const std::string &filename, std::vector<PgnGame> &games);
+
+#endif // PGN_H_
@@ -9,51 +9,68 @@
 class Board;
 class Move;
 
-// Abstract class for the pieces of the game. A piece has a color, a position on
-// the board, and a captured attribute. The only non-trivial method is getMoves()
-// It is reponsible to compute all possible Moves for this piece on a board.
+// the char of each PieceCode in the standard algebraic notation, ' ' for a
+// pawn (see Piece::notation())
+constexpr char PIECE_NOTATION[16] = {'?', ' ', 'N', 'B', 'R', 'Q', 'K', '?',
+                                     '?', ' ', 'N', 'B', 'R', 'Q', 'K', '?'};
+
+// the char of each PieceCode on the display of the board, upper case for
+// White (see Piece::toChar())
+constexpr char PIECE_CHAR[16] = {'?', 'P', 'N', 'B', 'R', 'Q', 'K', '?',
+                                 '?', 'p', 'n', 'b', 'r', 'q', 'k', '?'};
+
+// A piece of the game: its code, its position on the board, and a captured
+// attribute. The only non-trivial method is getMoves(). It is reponsible to
+// compute all possible Moves for this piece on a board, and dispatches on
+// the type of the piece to the generators of movegen.h: there is no
+// virtual call.
 //
 // Typically, the 16 pieces need for the game are created at the beginning and
 // deleted at the end.
 class Piece {
 public:
-    Piece(Position, Color);
+    Piece(Position, Color, PieceType);
 
-    // returns the char used in the standard algebric notation of the piece
-    // exception returns ' ' for a Pawn (see Pawn)
-    virtual char notation() const = 0;
+    PieceType type() const {
+        return pieceType(code_);
+    }
 
+    PieceCode code() const {
+        return code_;
+    }
+
+    // returns the char used in the standard algebric notation of the piece
+    // exception returns ' ' for a Pawn
+    char notation() const {
+        return PIECE_NOTATION[code_];
+    }
 
     // returns the char used for display of the board
-    virtual char toChar() const = 0;
+    char toChar() const {
+        return PIECE_CHAR[code_];
+    }
 
     // push_back in res all possible moves for this piece on board b
-    virtual void getMoves(const Board &b, std::vector<Move *> &res) const = 0;
+    void getMoves(const Board &b, MoveList &res) const;
 
-    bool isCaptured() const;
+    bool isCaptured() const {
+        return is_captured_;
+    }
 
     void setCaptured(bool);
 
-    Color getColor() const;
+    Color getColor() const {
+        return pieceColor(code_);
+    }
 
     void setPosition(Position);
 
-    Position getPosition() const;
-
-protected:
-    // Utility function used by the various "getMoves()" methods to transform
-    // a starting position 'from' and a vector of position 'tos' to a vector
-    // of moves. Each move is a basic move, with or without capture, from
-    // position 'from' to a position in vector 'tos'.
-    //
-    // More specifically, the resulting moves are 'pushed back' on the vector res
-    // given a parameter.
-    static void positionsToMoves(const Board &g, Position from,
-                      const std::vector<Position> &tos,
-                      std::vector<Move *> &res);
+    Position getPosition() const {
+        return position_;
+    }
 
 private:
-    Color color_;
+    PieceCode code_;
     Position position_;
     bool is_captured_ = false;
 };
@@ -0,0 +1,117 @@
+// This program measures the thread pool (see threadpool.h):
+//
+//   poolbench [max_threads] [perft_depth]
+//
+// . the overhead of a task: empty tasks submitted from outside the pool, from
+//   a worker (its own deque), and through parallelFor(), in ns per task
+// . the scaling: the same work run with 1, 2, 4... max_threads workers (the
+//   number of hardware threads by default): small tasks of about 10 us, and
+//   a parallel perft of depth perft_depth (4 by default) from the initial
+//   position.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "threadpool.h"
+#include "perft.h"
+
+const int OVERHEAD_TASKS = 200000;
+const int SPIN_TASKS = 20000;
+
+static volatile uint64_t sink;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// about 10 us of computation
+static void spin() {
+    uint64_t x = 88172645463325252ULL;
+    for (int i = 0; i < 5000; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    sink = x;
+}
+
+static void overhead(int nthreads) {
+    ThreadPool pool(nthreads);
+    std::atomic<long> count(0);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        TaskGroup g(pool);
+        for (int i = 0; i < OVERHEAD_TASKS; i++) {
+            g.run([&count]() { count++; });
+        }
+        g.wait();
+    }
+    double external = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    {
+        TaskGroup outer(pool);
+        outer.run([&pool, &count]() {
+            TaskGroup g(pool);
+            for (int i = 0; i < OVERHEAD_TASKS; i++) {
+                g.run([&count]() { count++; });
+            }
+            g.wait();
+        });
+        outer.wait();
+    }
+    double worker = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    parallelFor(pool, OVERHEAD_TASKS, [&count](size_t, int) { count++; });
+    double loop = secondsSince(start);
+
+    std::cout << "overhead with " << pool.size() << " workers (ns per empty task):" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  submitted from outside    " << std::setw(8) << external * 1e9 / OVERHEAD_TASKS << std::endl;
+    std::cout << "  submitted from a worker   " << std::setw(8) << worker * 1e9 / OVERHEAD_TASKS << std::endl;
+    std::cout << "  parallelFor, grain 1      " << std::setw(8) << loop * 1e9 / OVERHEAD_TASKS << std::endl;
+    std::cout << std::defaultfloat;
+}
+
+int main(int argc, char **argv) {
+    int max_threads = (argc >= 2) ? std::stoi(argv[1]) :
+                      std::max(1u, std::thread::hardware_concurrency());
+    int depth = (argc >= 3) ? std::stoi(argv[2]) : 4;
+
+    overhead(max_threads);
+
+    std::cout << std::endl << "scaling:" << std::endl;
+    std::cout << "threads   spin tasks (s)  speedup     perft " << depth << " (s)  speedup" << std::endl;
+    double spin_1 = 0;
+    double perft_1 = 0;
+    for (int n = 1; n <= max_threads; n = (n == max_threads) ? n + 1 : std::min(2 * n, max_threads)) {
+        ThreadPool pool(n);
+        auto start = std::chrono::steady_clock::now();
+        parallelFor(pool, SPIN_TASKS, [](size_t, int) { spin(); });
+        double spin_s = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        uint64_t leaves = parallelPerft(pool, START_FEN, depth, NULL);
+        double perft_s = secondsSince(start);
+        sink = leaves;
+
+        if (n == 1) {
+            spin_1 = spin_s;
+            perft_1 = perft_s;
+        }
+        std::cout << std::fixed << std::setprecision(3) << std::setw(7) << n
+                  << std::setw(17) << spin_s << std::setprecision(2) << std::setw(9) << spin_1 / spin_s
+                  << std::setprecision(3) << std::setw(18) << perft_s
+                  << std::setprecision(2) << std::setw(9) << perft_1 / perft_s
+                  << std::defaultfloat << std::endl;
+    }
+    return 0;
+}
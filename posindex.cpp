@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "posindex.h"
+#include "gamestore.h"
+#include "pgn.h"
+#include "replay.h"
+
+static const char PROMOTIONS[] = "QRBN";
+
+uint16_t encodeMove(const Move *m, char promotion) {
+    Position from = m->getFrom();
+    Position to = m->getTo();
+    uint16_t code = (from.first * 8 + from.second) + 64 * (to.first * 8 + to.second);
+    if (promotion != ' ') {
+        code += 4096 * (strchr(PROMOTIONS, promotion) - PROMOTIONS);
+    }
+    return code;
+}
+
+// the order of the index: by position, then game, then ply
+static bool entryLess(const PositionEntry &x, const PositionEntry &y) {
+    if (x.key != y.key) {
+        return x.key < y.key;
+    }
+    if (x.game != y.game) {
+        return x.game < y.game;
+    }
+    return x.ply < y.ply;
+}
+
+static std::string runName(const std::string &filename, int run) {
+    return filename + ".run" + std::to_string(run);
+}
+
+// sorts the entries and writes them in run file number run.
+static bool writeRun(const std::string &filename, int run,
+                     std::vector<PositionEntry> &entries) {
+    std::sort(entries.begin(), entries.end(), entryLess);
+    std::ofstream file(runName(filename, run), std::ios::binary);
+    file.write((const char *) entries.data(), entries.size() * sizeof(PositionEntry));
+    entries.clear();
+    return (bool) file;
+}
+
+// reads the next entry of run in e. Returns 1 if it is read, 0 at the end
+// of the run, and -1 on a read error or a truncated entry.
+static int readEntry(std::ifstream &run, PositionEntry &e) {
+    if (run.read((char *) &e, sizeof(e))) {
+        return 1;
+    }
+    return (run.eof() && !run.bad() && run.gcount() == 0) ? 0 : -1;
+}
+
+static void removeFiles(const std::vector<std::string> &names) {
+    for (const auto &name : names) {
+        remove(name.c_str());
+    }
+}
+
+// merges the sorted run files inputs in output, preceded by the header of
+// an index if index, and deletes them. Returns false if a run can't be read
+// or output can't be written, output being then removed if it was created.
+static bool mergeFiles(const std::vector<std::string> &inputs, const std::string &output,
+                       bool index) {
+    bool ok = true;
+    std::vector<std::unique_ptr<std::ifstream> > runs;
+    for (const auto &name : inputs) {
+        runs.emplace_back(new std::ifstream(name, std::ios::binary));
+        ok = ok && (bool) *runs.back();
+    }
+    // the smallest entry of each run, the smallest one on top
+    typedef std::pair<PositionEntry, int> Head;
+    auto greater = [](const Head &x, const Head &y) {
+        return entryLess(y.first, x.first);
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads(greater);
+    PositionEntry e;
+    for (size_t r = 0; ok && r < runs.size(); r++) {
+        int read = readEntry(*runs[r], e);
+        if (read > 0) {
+            heads.push({e, (int) r});
+        }
+        ok = read >= 0;
+    }
+
+    std::ofstream file;
+    bool created = false;
+    if (ok) {
+        file.open(output, std::ios::binary);
+        ok = created = (bool) file;
+    }
+    PositionIndexHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, POSINDEX_MAGIC, sizeof(h.magic));
+    h.version = POSINDEX_VERSION;
+    if (ok && index) {
+        file.write((const char *) &h, sizeof(h));
+    }
+    while (ok && !heads.empty()) {
+        Head head = heads.top();
+        heads.pop();
+        file.write((const char *) &head.first, sizeof(PositionEntry));
+        h.entry_count++;
+        int read = readEntry(*runs[head.second], e);
+        if (read > 0) {
+            heads.push({e, head.second});
+        }
+        ok = read >= 0 && (bool) file;
+    }
+    if (ok && index) {
+        file.seekp(0);
+        file.write((const char *) &h, sizeof(h));
+    }
+    if (file.is_open()) {
+        file.close();
+        ok = ok && !file.fail();
+    }
+    runs.clear();
+    removeFiles(inputs);
+    if (!ok && created) {
+        remove(output.c_str());
+    }
+    return ok;
+}
+
+// merges the nruns sorted run files in the index filename, and deletes them.
+// Beyond POSINDEX_MERGE_FANIN runs, the runs are merged by groups into
+// longer ones, numbered after them, until they are few enough.
+static bool mergeRuns(const std::string &filename, int nruns) {
+    std::vector<std::string> runs;
+    for (int r = 0; r < nruns; r++) {
+        runs.push_back(runName(filename, r));
+    }
+    int next = nruns;
+    bool ok = true;
+    while (runs.size() > POSINDEX_MERGE_FANIN) {
+        std::vector<std::string> merged;
+        for (size_t first = 0; first < runs.size(); first += POSINDEX_MERGE_FANIN) {
+            size_t last = std::min(first + POSINDEX_MERGE_FANIN, runs.size());
+            std::vector<std::string> group(runs.begin() + first, runs.begin() + last);
+            if (!ok) {
+                removeFiles(group);
+                continue;
+            }
+            merged.push_back(runName(filename, next++));
+            ok = mergeFiles(group, merged.back(), false);
+        }
+        runs = merged;
+        if (!ok) {
+            removeFiles(runs);
+            return false;
+        }
+    }
+    return mergeFiles(runs, filename, true);
+}
+
+bool buildPositionIndex(const std::string &input, const std::string &filename,
+                        ThreadPool &pool, size_t memory_mb, size_t *games) {
+    GameStore store;
+    std::ifstream pgn_file;
+    bool from_store = store.open(input);
+    if (!from_store) {
+        pgn_file.open(input);
+        if (!pgn_file) {
+            return false;
+        }
+    }
+
+    // each worker has its own board and buffer, the total being memory_mb
+    // megabytes
+    size_t capacity = std::max<size_t>(1024, memory_mb * 1024 * 1024 /
+                                              sizeof(PositionEntry) / pool.size());
+    std::atomic<int> nruns(0);
+    std::atomic<bool> ok(true);
+    std::vector<Board> boards(pool.size());
+    std::vector<std::vector<PositionEntry> > buffers(pool.size());
+    // indexes game i, read from the store if pgn is NULL
+    auto indexGame = [&](size_t i, int worker, const PgnGame *pgn) {
+        Board &b = boards[worker];
+        std::vector<PositionEntry> &buffer = buffers[worker];
+        uint16_t result = (pgn == NULL) ? store.record(i).result : parseResult(pgn->result);
+        std::vector<PositionEntry> game;
+        auto visit = [&](Board &b, Move *m, char promotion) {
+            uint16_t ply = game.size();
+            game.push_back({b.hash(), (uint32_t) i, ply,
+                            (uint16_t) (encodeMove(m, promotion) | result << 14)});
+        };
+        ReplayResult res;
+        bool legal = (pgn == NULL) ? store.replay(i, b, visit) :
+                                     replayGame(b, *pgn, res, visit);
+        if (!legal) {
+            return;
+        }
+        for (const auto &e : game) {
+            buffer.push_back(e);
+            if (buffer.size() == capacity && !writeRun(filename, nruns++, buffer)) {
+                ok = false;
+            }
+        }
+    };
+    if (from_store) {
+        *games = store.size();
+        parallelFor(pool, *games, [&](size_t i, int worker) {
+            indexGame(i, worker, NULL);
+        });
+    } else {
+        *games = 0;
+        std::vector<PgnGame> batch(POSINDEX_PGN_BATCH);
+        size_t n;
+        do {
+            n = 0;
+            while (n < batch.size() && readPgnGame(pgn_file, batch[n])) {
+                n++;
+            }
+            size_t first = *games;
+            parallelFor(pool, n, [&](size_t i, int worker) {
+                indexGame(first + i, worker, &batch[i]);
+            });
+            *games += n;
+        } while (n == batch.size());
+    }
+    for (auto &buffer : buffers) {
+        if (!buffer.empty() && !writeRun(filename, nruns++, buffer)) {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        for (int r = 0; r < nruns; r++) {
+            remove(runName(filename, r).c_str());
+        }
+        return false;
+    }
+    return mergeRuns(filename, nruns);
+}
+
+PositionIndex::PositionIndex() { }
+
+PositionIndex::~PositionIndex() {
+    close();
+}
+
+bool PositionIndex::open(const std::string &filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(PositionIndexHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    data_ = (const uint8_t *) data;
+    length_ = st.st_size;
+    const PositionIndexHeader *h = (const PositionIndexHeader *) data_;
+    if (memcmp(h->magic, POSINDEX_MAGIC, sizeof(POSINDEX_MAGIC)) != 0 ||
+        h->version != POSINDEX_VERSION ||
+        sizeof(PositionIndexHeader) + h->entry_count * sizeof(PositionEntry) > length_) {
+        close();
+        return false;
+    }
+    entries_ = (const PositionEntry *) (data_ + sizeof(PositionIndexHeader));
+    count_ = h->entry_count;
+    return true;
+}
+
+void PositionIndex::close() {
+    if (data_ != NULL) {
+        munmap((void *) data_, length_);
+    }
+    data_ = NULL;
+    length_ = 0;
+    entries_ = NULL;
+    count_ = 0;
+}
+
+size_t PositionIndex::size() const {
+    return count_;
+}
+
+void PositionIndex::find(uint64_t key, const PositionEntry **first,
+                         const PositionEntry **last) const {
+    auto less = [](const PositionEntry &e, uint64_t key) {
+        return e.key < key;
+    };
+    *first = std::lower_bound(entries_, entries_ + count_, key, less);
+    *last = *first;
+    while (*last < entries_ + count_ && (*last)->key == key) {
+        (*last)++;
+    }
+}
+
+void PositionIndex::explore(uint64_t key, std::vector<MoveStats> &stats) const {
+    stats.clear();
+    const PositionEntry *first;
+    const PositionEntry *last;
+    find(key, &first, &last);
+    for (const PositionEntry *e = first; e < last; e++) {
+        uint16_t move = e->move_result & 0x3FFF;
+        size_t k = 0;
+        while (k < stats.size() && stats[k].move != move) {
+            k++;
+        }
+        if (k == stats.size()) {
+            stats.push_back(MoveStats());
+            stats[k].move = move;
+        }
+        stats[k].games++;
+        switch (e->move_result >> 14) {
+          case RESULT_WHITE:
+            stats[k].white++;
+            break;
+          case RESULT_BLACK:
+            stats[k].black++;
+            break;
+          case RESULT_DRAW:
+            stats[k].draws++;
+            break;
+          default:
+            break;
+        }
+    }
+    std::stable_sort(stats.begin(), stats.end(), [](const MoveStats &x, const MoveStats &y) {
+        return x.games > y.games;
+    });
+}
@@ -0,0 +1,116 @@
+// This module builds and reads an index of all the positions reached in a
+// collection of games, to find the games that went through a position and
+// the moves that were played from it (an "opening explorer").
+//
+// The index is a file made of a header followed by PositionEntry records,
+// one per move played in the games, sorted by Zobrist key (see
+// Board::hash()). All the moves played from a position are therefore next to
+// each other, and are found by a binary search in the file mapped with mmap().
+//
+// The index is built in bounded memory: the games are replayed by the workers
+// of a thread pool, each one filling a buffer of entries. The games of a PGN
+// file are read POSINDEX_PGN_BATCH at a time, so the file is never held whole
+// in memory, and those of a game store are read from the mapped file. A full
+// buffer is sorted and
+// written to a temporary "run" file, and the runs are merged at the end, at
+// most POSINDEX_MERGE_FANIN at a time: beyond that, groups of runs are first
+// merged into longer runs, so that the open files stay few whatever the
+// size of the collection and of the buffers.
+
+#ifndef POSINDEX_H_
+#define POSINDEX_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "move.h"
+#include "gamestore.h"
+#include "threadpool.h"
+
+const char POSINDEX_MAGIC[4] = {'C', 'P', 'I', 'X'};
+// version 2: the keys include the castling rights and the en passant square
+const uint32_t POSINDEX_VERSION = 2;
+
+// the number of runs merged at once, see buildPositionIndex()
+const size_t POSINDEX_MERGE_FANIN = 64;
+
+// the number of games of a PGN file read and shared among the workers at
+// once, see buildPositionIndex()
+const size_t POSINDEX_PGN_BATCH = 4096;
+
+struct PositionIndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t entry_count;
+};
+
+struct PositionEntry {
+    // the position before the move
+    uint64_t key;
+    // the index of the game in the PGN file or game store
+    uint32_t game;
+    // the number of moves played before in the game
+    uint16_t ply;
+    // the move, see encodeMove(), and the GameResult in the two high bits
+    uint16_t move_result;
+};
+
+static_assert(sizeof(PositionEntry) == 16, "PositionEntry must be 16 bytes");
+
+// returns the 14 bits code of move m: from + 64 * to + 4096 * promotion, where
+// a position {i,j} is numbered 8*i + j and promotion is the index of the new
+// piece in "QRBN" (0 if the move is not a promotion).
+uint16_t encodeMove(const Move *m, char promotion);
+
+// builds the index filename of the games of input, a PGN file or a game store
+// (see gamestore.h), on the workers of pool and with about memory_mb
+// megabytes of buffers. The number of games read is stored in *games, and the
+// games with an illegal move are skipped.
+// returns false if input can't be read, or if filename or a run can't be
+// written or read back: the runs, and filename if it was written, are then
+// removed.
+bool buildPositionIndex(const std::string &input, const std::string &filename,
+                        ThreadPool &pool, size_t memory_mb, size_t *games);
+
+// Statistics of a move played from a position.
+struct MoveStats {
+    uint16_t move;
+    uint32_t games = 0;
+    uint32_t white = 0;
+    uint32_t draws = 0;
+    uint32_t black = 0;
+};
+
+// An index opened for reading.
+class PositionIndex {
+public:
+    PositionIndex();
+
+    ~PositionIndex();
+
+    // maps the file filename in memory. returns false if it is not a valid
+    // index.
+    bool open(const std::string &filename);
+
+    void close();
+
+    // number of entries
+    size_t size() const;
+
+    // sets [*first, *last) to the entries of the position key
+    void find(uint64_t key, const PositionEntry **first, const PositionEntry **last) const;
+
+    // replaces stats by the moves played from the position key, with their
+    // number of games and results, the most played first
+    void explore(uint64_t key, std::vector<MoveStats> &stats) const;
+
+private:
+    const uint8_t *data_ = NULL;
+    size_t length_ = 0;
+    const PositionEntry *entries_ = NULL;
+    size_t count_ = 0;
+};
+
+#endif // POSINDEX_H_
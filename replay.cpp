@@ -0,0 +1,49 @@
+#include <string>
+#include <vector>
+#include "replay.h"
+#include "board.h"
+#include "move.h"
+#include "notation.h"
+#include "pgn.h"
+
+bool replayGame(Board &b, const PgnGame &g, ReplayResult &res,
+                const MoveVisitor &visit) {
+    res.plies = 0;
+    res.error = "";
+    std::string fen = g.tag("FEN");
+    if (fen.empty()) {
+        b.reset();
+    } else if (!b.fromFEN(fen)) {
+        res.error = "FEN";
+        return false;
+    }
+    for (const auto &san : g.moves) {
+        char promotion;
+        Move *m = parseMove(b, san, &promotion);
+        if (m == NULL) {
+            res.error = san;
+            return false;
+        }
+        if (visit) {
+            visit(b, m, promotion);
+        }
+        m->perform(&b);
+        b.switch_player();
+        if (promotion != ' ') {
+            b.promote_pawn_b(m, std::string(1, promotion));
+        }
+        // the move is never unperformed, the board doesn't need it anymore
+        delete m;
+        res.plies++;
+    }
+    return true;
+}
+
+void replayGames(const std::vector<PgnGame> &games, ThreadPool &pool,
+                 std::vector<ReplayResult> &results) {
+    results.assign(games.size(), ReplayResult());
+    std::vector<Board> boards(pool.size());
+    parallelFor(pool, games.size(), [&](size_t i, int worker) {
+        replayGame(boards[worker], games[i], results[i], MoveVisitor());
+    });
+}
@@ -0,0 +1,41 @@
+// This module replays the games read from a PGN file (see pgn.h) without any
+// display, to check that all their moves are legal. The games are shared
+// among the workers of a thread pool, each one replaying its games on its
+// own Board.
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "pgn.h"
+#include "threadpool.h"
+
+struct ReplayResult {
+    // number of moves played
+    int plies = 0;
+
+    // the first move that is not legal, or "" if the whole game was played
+    std::string error;
+};
+
+// called before each move m is played on b during a replay. promotion is the
+// letter of the piece a pawn is promoted to, or ' '.
+typedef std::function<void(Board &b, Move *m, char promotion)> MoveVisitor;
+
+// replays game g on board b, starting from the initial position, or from the
+// position of its FEN tag if it has one, calling visit (if not empty) before
+// each move.
+// returns true if all the moves of g are legal (res.error being "FEN" if the
+// FEN tag is not valid).
+bool replayGame(Board &b, const PgnGame &g, ReplayResult &res,
+                const MoveVisitor &visit);
+
+// replays all games on the workers of pool. results[i] receives the result
+// of games[i].
+void replayGames(const std::vector<PgnGame> &games, ThreadPool &pool,
+                 std::vector<ReplayResult> &results);
+
+#endif // REPLAY_H_
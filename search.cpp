@@ -0,0 +1,419 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include "search.h"
+#include "piece.h"
+#include "searchstats.h"
+#include "trace.h"
+#include "posindex.h"
+
+// values of the pieces, in the order of " NBRQK", used to order the captures
+static int pieceValue(const Piece *p) {
+    switch (p->notation()) {
+      case ' ':
+        return 1;
+      case 'N':
+      case 'B':
+        return 3;
+      case 'R':
+        return 5;
+      case 'Q':
+        return 10;
+      default:
+        return 100;
+    }
+}
+
+static bool sameMove(const Move *x, const Move *y) {
+    return x->getFrom() == y->getFrom() && x->getTo() == y->getTo();
+}
+
+static void play(Board &b, Move *m) {
+    bool promotes = m->isPromotion();
+    m->perform(&b);
+    b.switch_player();
+    if (promotes) {
+        b.promote_pawn_b(m, "Q");
+    }
+}
+
+static void unplay(Board &b, Move *m) {
+    if (m->isPromotion()) {
+        b.unpromote_pawn_b(m);
+    }
+    b.switch_player();
+    m->unPerform(&b);
+}
+
+// deletes the moves of v from index first
+static void deleteFrom(std::vector<Move *> &v, size_t first) {
+    for (size_t k = first; k < v.size(); k++) {
+        delete v[k];
+    }
+    v.resize(std::min(first, v.size()));
+}
+
+void deletePV(SearchResult &r, Move *kept) {
+    for (auto m : r.pv) {
+        if (m != kept) {
+            delete m;
+        }
+    }
+    r.pv.clear();
+    r.best = NULL;
+}
+
+#ifdef SEARCH_STATS
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+#endif
+
+// fills moves with the legal moves of b of kind type, see
+// Board::getAllLegalMoves()
+static void generate(Board &b, int iteration, MoveList &moves, GenType type = ALL) {
+#ifdef SEARCH_STATS
+    auto start = std::chrono::steady_clock::now();
+    b.getAllLegalMoves(type, moves);
+    IterationStats &st = threadSearchStats().iteration(iteration);
+    st.movegen_ns += elapsedNs(start);
+    st.moves_generated += moves.size();
+#else
+    b.getAllLegalMoves(type, moves);
+#endif
+}
+
+// returns Board::evaluate() of b, from cache if it is there
+static int cachedEvaluate(const Board &b, EvalCache &cache, int iteration) {
+    int score;
+    SEARCH_STAT(threadSearchStats().iteration(iteration).eval_cache_probes++);
+    if (cache.probe(b.hash(), &score)) {
+        SEARCH_STAT(threadSearchStats().iteration(iteration).eval_cache_hits++);
+        return score;
+    }
+    score = b.evaluate();
+    cache.store(b.hash(), score);
+    return score;
+}
+
+// returns the static evaluation of b for the player to move
+static int evaluate(const Board &b, EvalCache &cache, int iteration) {
+#ifdef SEARCH_STATS
+    auto start = std::chrono::steady_clock::now();
+    int score = cachedEvaluate(b, cache, iteration);
+    threadSearchStats().iteration(iteration).eval_ns += elapsedNs(start);
+#else
+    int score = cachedEvaluate(b, cache, iteration);
+#endif
+    return b.getPlayer() == WHITE ? score : -score;
+}
+
+#ifdef SEARCH_TRACE
+// records a node in the trace of the thread, if there is one
+static void traceNode(uint16_t move, int iteration, long nodes, int ply, int depth,
+                      int alpha, int beta, int score, bool quiescence, size_t cutoff) {
+    TraceWriter *trace = threadTrace();
+    if (trace == NULL) {
+        return;
+    }
+    TraceRecord r;
+    r.subtree_nodes = nodes;
+    r.alpha = alpha;
+    r.beta = beta;
+    r.score = score;
+    r.move = move;
+    r.iteration = iteration;
+    r.ply = ply;
+    r.depth = depth;
+    r.type = traceNodeType(alpha, beta, score) | (quiescence ? NODE_QUIESCENCE : 0);
+    r.cutoff_index = std::min<size_t>(cutoff, NO_CUTOFF);
+    trace->record(r);
+}
+#endif
+
+Search::Search() { }
+
+long Search::nodes() const {
+    return nodes_;
+}
+
+void Search::setTable(TranspositionTable *tt) {
+    tt_ = tt;
+}
+
+void Search::setEvalCacheSize(size_t size_kb) {
+    eval_cache_ = EvalCache(size_kb);
+}
+
+void Search::setStop(const std::atomic<bool> *stop) {
+    stop_ = stop;
+}
+
+void Search::setIterationVisitor(IterationVisitor visit) {
+    visit_ = visit;
+}
+
+// the time of the steady clock, in ns
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Search::setTimeLimit(long ms) {
+    deadline_ns_ = (ms > 0) ? nowNs() + (int64_t) ms * 1000000 : 0;
+}
+
+bool Search::stopping() {
+    if (stopped_ || iteration_ <= 1) {
+        return stopped_;
+    }
+    // the clock is read every 1024 nodes
+    stopped_ = (node_limit_ > 0 && nodes_ >= node_limit_) ||
+               (stop_ != NULL && stop_->load(std::memory_order_relaxed)) ||
+               ((nodes_ & 1023) == 0 && deadline_ns_.load(std::memory_order_relaxed) != 0 &&
+                nowNs() >= deadline_ns_.load(std::memory_order_relaxed));
+    return stopped_;
+}
+
+// the code of m in the transposition table
+static uint16_t ttMove(const Move *m) {
+    return encodeMove(m, m->isPromotion() ? 'Q' : ' ');
+}
+
+void Search::order(const Board &b, int ply, uint16_t tt_move, MoveList &moves) const {
+    const Move *pv = ((size_t) ply < pv_.size()) ? pv_[ply] : NULL;
+    ArenaScope scope(*arena_);
+    std::pmr::vector<std::pair<int, Move *> > keyed(arena_);
+    keyed.reserve(moves.size());
+    for (auto m : moves) {
+        int key = 0;
+        Piece *victim;
+        if (pv != NULL && sameMove(m, pv)) {
+            key = 1000000;
+        } else if (tt_move != TT_NO_MOVE && ttMove(m) == tt_move) {
+            key = 900000;
+        } else if (m->doesCapture(NULL) && b.getPiece(m->getTo(), &victim)) {
+            key = 1000 * pieceValue(victim) - pieceValue(m->getMoved());
+        }
+        keyed.push_back({key, m});
+    }
+    // a stable insertion sort: the lists are short, and std::stable_sort
+    // would allocate its buffer on the heap
+    for (size_t k = 1; k < keyed.size(); k++) {
+        std::pair<int, Move *> x = keyed[k];
+        size_t j = k;
+        for (; j > 0 && keyed[j - 1].first < x.first; j--) {
+            keyed[j] = keyed[j - 1];
+        }
+        keyed[j] = x;
+    }
+    for (size_t k = 0; k < moves.size(); k++) {
+        moves[k] = keyed[k].second;
+    }
+}
+
+SearchResult Search::run(Board &b, int depth, long max_nodes, long max_ms) {
+    SearchResult r;
+    long start = nodes_;
+    node_limit_ = (max_nodes > 0) ? start + max_nodes : 0;
+    if (max_ms > 0) {
+        setTimeLimit(max_ms);
+    }
+    stopped_ = false;
+    arena_ = &threadArena();
+    if (tt_ != NULL) {
+        tt_->newSearch();
+    }
+    eval_cache_.newSearch(b.evalTerms());
+    SEARCH_STAT(uint64_t prev_nodes = 0);
+    for (int d = 1; d <= depth; d++) {
+        iteration_ = d;
+        SEARCH_TRACE_DO(trace_move_ = NO_MOVE);
+        // the iteration is counted alone, then added to the previous ones
+        SEARCH_STAT(IterationStats previous = threadSearchStats().iteration(d));
+        SEARCH_STAT(threadSearchStats().iteration(d) = IterationStats());
+        std::vector<Move *> pv;
+        int score = alphaBeta(b, d, 0, -MATE - 1, MATE + 1, pv);
+#ifdef SEARCH_STATS
+        IterationStats &it = threadSearchStats().iteration(d);
+        printIterationStats(std::cerr, d, it, prev_nodes);
+        prev_nodes = it.nodes + it.qnodes;
+        it.add(previous);
+#endif
+        if (stopped_) {
+            // the iteration is incomplete, the previous one is kept
+            deleteFrom(pv, 0);
+            break;
+        }
+        r.score = score;
+        r.depth = d;
+        deleteFrom(pv_, 0);
+        pv_ = pv;
+        if (visit_) {
+            r.pv = pv_;
+            r.best = r.pv.empty() ? NULL : r.pv[0];
+            r.nodes = nodes_ - start;
+            visit_(r);
+        }
+        if (pv_.empty() || r.score >= MATE - d || r.score <= -MATE + d) {
+            // no legal move, or a mate was found: deeper searches won't change
+            break;
+        }
+    }
+    r.pv = pv_;
+    r.best = r.pv.empty() ? NULL : r.pv[0];
+    r.nodes = nodes_ - start;
+    pv_.clear();
+    deadline_ns_ = 0;
+    SEARCH_STAT(mergeSearchStats());
+    return r;
+}
+
+int Search::alphaBeta(Board &b, int depth, int ply, int alpha, int beta,
+                      std::vector<Move *> &pv) {
+    // the root is always searched, to return a move
+    if (ply > 0 && b.isDraw()) {
+        return 0;
+    }
+    if (depth == 0) {
+        return quiescence(b, ply, alpha, beta);
+    }
+    if (stopping()) {
+        return 0;
+    }
+    SEARCH_TRACE_DO(uint16_t move = trace_move_;
+                    long first_node = nodes_;)
+    int alpha0 = alpha;
+    nodes_++;
+    SEARCH_STAT(threadSearchStats().iteration(iteration_).nodes++);
+    uint16_t tt_move = TT_NO_MOVE;
+    if (tt_ != NULL) {
+        SEARCH_STAT(threadSearchStats().iteration(iteration_).tt_probes++);
+        const TTEntry *e = tt_->probe(b.hash());
+        if (e != NULL) {
+            SEARCH_STAT(threadSearchStats().iteration(iteration_).tt_hits++);
+            tt_move = e->move;
+            int score = scoreFromTT(e->score, ply);
+            // the root is always searched, to return a move
+            if (ply > 0 && e->depth >= depth &&
+                (e->bound() == TT_EXACT || (e->bound() == TT_LOWER && score >= beta) ||
+                 (e->bound() == TT_UPPER && score <= alpha))) {
+                SEARCH_STAT(threadSearchStats().iteration(iteration_).tt_cutoffs++);
+                SEARCH_TRACE_DO(traceNode(move, iteration_, nodes_ - first_node, ply, depth,
+                                          alpha0, beta, score, false, NO_CUTOFF));
+                return score;
+            }
+        }
+    }
+    // the moves of the node are in the arena until it returns
+    ArenaScope scope(*arena_);
+    MoveList moves(arena_);
+    generate(b, iteration_, moves);
+    if (moves.empty()) {
+        int score = b.isInCheck(b.getPlayer()) ? -MATE + ply : 0;
+        SEARCH_TRACE_DO(traceNode(move, iteration_, nodes_ - first_node, ply, depth,
+                                  alpha0, beta, score, false, NO_CUTOFF));
+        return score;
+    }
+    order(b, ply, tt_move, moves);
+    std::vector<Move *> child;
+    size_t k;
+    for (k = 0; k < moves.size(); k++) {
+        Move *m = moves[k];
+        SEARCH_TRACE_DO(trace_move_ = encodeMove(m, m->isPromotion() ? 'Q' : ' '));
+        play(b, m);
+        int score = -alphaBeta(b, depth - 1, ply + 1, -beta, -alpha, child);
+        unplay(b, m);
+        if (stopped_) {
+            deleteFrom(child, 0);
+            break;
+        }
+        if (score > alpha) {
+            // pv[0] is one of moves, deleted below if it is replaced
+            alpha = score;
+            deleteFrom(pv, 1);
+            pv.clear();
+            pv.push_back(m);
+            pv.insert(pv.end(), child.begin(), child.end());
+            child.clear();
+            if (alpha >= beta) {
+#ifdef SEARCH_STATS
+                IterationStats &st = threadSearchStats().iteration(iteration_);
+                st.cutoffs++;
+                st.first_move_cutoffs += (k == 0);
+#endif
+                break;
+            }
+        } else {
+            deleteFrom(child, 0);
+        }
+    }
+    SEARCH_STAT(threadSearchStats().iteration(iteration_).moves_searched +=
+                std::min(k + 1, moves.size()));
+    SEARCH_TRACE_DO(traceNode(move, iteration_, nodes_ - first_node, ply, depth, alpha0,
+                              beta, alpha, false, k < moves.size() ? k : NO_CUTOFF));
+    if (tt_ != NULL && !stopped_) {
+        TTBound bound = (alpha >= beta) ? TT_LOWER : (alpha > alpha0) ? TT_EXACT : TT_UPPER;
+        tt_->store(b.hash(), scoreToTT(alpha, ply), (alpha > alpha0) ? ttMove(pv[0]) : TT_NO_MOVE,
+                   depth, bound);
+    }
+    for (auto m : moves) {
+        if (pv.empty() || m != pv[0]) {
+            delete m;
+        }
+    }
+    return alpha;
+}
+
+int Search::quiescence(Board &b, int ply, int alpha, int beta) {
+    if (stopping()) {
+        return 0;
+    }
+    SEARCH_TRACE_DO(uint16_t move = trace_move_;
+                    long first_node = nodes_;
+                    int alpha0 = alpha;
+                    size_t cutoff = NO_CUTOFF;)
+    nodes_++;
+    SEARCH_STAT(threadSearchStats().iteration(iteration_).qnodes++);
+    if (!b.hasLegalMove()) {
+        int score = b.isInCheck(b.getPlayer()) ? -MATE + ply : 0;
+        SEARCH_TRACE_DO(traceNode(move, iteration_, nodes_ - first_node, ply, 0,
+                                  alpha0, beta, score, true, NO_CUTOFF));
+        return score;
+    }
+    int stand_pat = evaluate(b, eval_cache_, iteration_);
+    if (stand_pat > alpha) {
+        alpha = stand_pat;
+    }
+    ArenaScope scope(*arena_);
+    MoveList moves(arena_);
+    if (alpha < beta) {
+        generate(b, iteration_, moves, CAPTURES);
+        order(b, -1, TT_NO_MOVE, moves);
+        for (size_t k = 0; k < moves.size(); k++) {
+            Move *m = moves[k];
+            SEARCH_STAT(threadSearchStats().iteration(iteration_).moves_searched++);
+            SEARCH_TRACE_DO(trace_move_ = encodeMove(m, m->isPromotion() ? 'Q' : ' '));
+            play(b, m);
+            int score = -quiescence(b, ply + 1, -beta, -alpha);
+            unplay(b, m);
+            if (stopped_) {
+                break;
+            }
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    SEARCH_TRACE_DO(cutoff = k);
+                    break;
+                }
+            }
+        }
+    }
+    SEARCH_TRACE_DO(traceNode(move, iteration_, nodes_ - first_node, ply, 0, alpha0,
+                              beta, alpha, true, cutoff));
+    for (auto m : moves) {
+        delete m;
+    }
+    return alpha;
+}
@@ -0,0 +1,140 @@
+// This module implements the search of the computer player.
+//
+// It is an alpha-beta search (in its negamax form) driven by iterative
+// deepening: the position is searched to depth 1, 2, ... up to the requested
+// depth, and the best line of an iteration (the principal variation, PV) is
+// tried first in the next one. At depth 0, a quiescence search that only
+// plays captures avoids evaluating positions in the middle of an exchange.
+// see https://www.chessprogramming.org/Alpha-Beta
+//
+// The positions drawn whatever the moves (see Board::isDraw()) are scored 0
+// without being searched: a position that repeats one of the line, or one of
+// the game before the root, ends a cycle instead of searching it again.
+//
+// The search is deterministic: for a given position, game before it and
+// depth it always visits the same nodes, so the number of nodes is a
+// signature of its behaviour (see bench.h). This holds without transposition
+// table, the only setting of the computer player and of the bench: with one
+// (see setTable()), the nodes depend on the positions searched before. The
+// evaluation cache (see setEvalCacheSize()) only saves evaluations: it
+// doesn't change the nodes.
+
+#ifndef SEARCH_H_
+#define SEARCH_H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include "board.h"
+#include "move.h"
+#include "transposition.h"
+#include "evalcache.h"
+#include "arena.h"
+
+// score of a mate, from the point of view of the player to move. A mate in n
+// plies is scored MATE - n.
+const int MATE = 1000000;
+
+// the depth of a search only limited by nodes or time
+const int MAX_SEARCH_DEPTH = 64;
+
+struct SearchResult {
+    // the best move, NULL if there is no legal move
+    Move *best = NULL;
+    // the score of the best move for the player to move
+    int score = 0;
+    // the depth of the last iteration
+    int depth = 0;
+    // the nodes visited by all the iterations
+    long nodes = 0;
+    // the principal variation, starting with best
+    std::vector<Move *> pv;
+};
+
+// called after each complete iteration of Search::run() with the result so
+// far. The moves of r.pv are only valid during the call.
+typedef std::function<void(const SearchResult &r)> IterationVisitor;
+
+class Search {
+public:
+    Search();
+
+    // searches b up to depth plies and returns the result. The moves of the
+    // result (the PV) belong to the caller, see deletePV().
+    // If max_nodes > 0, the search stops after about max_nodes nodes, and if
+    // max_ms > 0 after about max_ms milliseconds (see setTimeLimit()), and
+    // returns the result of the last complete iteration; the first one is
+    // always completed.
+    // b is left as it was found. The pawns are only promoted to queens.
+    SearchResult run(Board &b, int depth, long max_nodes = 0, long max_ms = 0);
+
+    // nodes visited since the creation of the Search
+    long nodes() const;
+
+    // the transposition table of the next searches, or NULL (the default) to
+    // search without. The table is not owned, and must not be used by
+    // another Search at the same time.
+    void setTable(TranspositionTable *tt);
+
+    // replaces the evaluation cache of the searches, of EVAL_CACHE_KB by
+    // default, by one of about size_kb kilobytes, 0 for none
+    void setEvalCacheSize(size_t size_kb);
+
+    // the next searches also stop (as with the limits of run()) as soon as
+    // *stop is true, e.g. set by another thread. NULL (the default) for no
+    // such stop.
+    void setStop(const std::atomic<bool> *stop);
+
+    // visit is called after each complete iteration of the next searches
+    void setIterationVisitor(IterationVisitor visit);
+
+    // stops the search in progress, or the next one, after about ms
+    // milliseconds from now (0 for no time limit). Unlike the other settings
+    // it can be called from another thread during run(), e.g. to give a time
+    // limit to a search started without. The limit is removed at the end of
+    // run().
+    void setTimeLimit(long ms);
+
+private:
+    int alphaBeta(Board &b, int depth, int ply, int alpha, int beta,
+                  std::vector<Move *> &pv);
+
+    int quiescence(Board &b, int ply, int alpha, int beta);
+
+    // sorts moves: the move of the previous PV at this ply first, then
+    // tt_move (the best move stored in the transposition table), then the
+    // captures of the most valuable pieces, then the other moves
+    void order(const Board &b, int ply, uint16_t tt_move, MoveList &moves) const;
+
+    // returns true if the search must stop, a limit being reached
+    bool stopping();
+
+    long nodes_ = 0;
+    // the value of nodes_ at which the search stops, 0 if there is no limit
+    long node_limit_ = 0;
+    // the time at which the search stops, in nanoseconds of the steady clock,
+    // 0 for no time limit
+    std::atomic<int64_t> deadline_ns_{0};
+    const std::atomic<bool> *stop_ = NULL;
+    IterationVisitor visit_;
+    bool stopped_ = false;
+    TranspositionTable *tt_ = NULL;
+    EvalCache eval_cache_;
+    // the arena of the thread of run(), for the moves of the nodes (see
+    // arena.h)
+    Arena *arena_ = NULL;
+    // the depth of the current iteration
+    int iteration_ = 0;
+#ifdef SEARCH_TRACE
+    // the move played to reach the node being entered, see trace.h
+    uint16_t trace_move_ = 0;
+#endif
+    // the PV of the previous iteration, used to order the moves
+    std::vector<Move *> pv_;
+};
+
+// deletes the moves of r.pv except kept (which may be NULL)
+void deletePV(SearchResult &r, Move *kept);
+
+#endif // SEARCH_H_
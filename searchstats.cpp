@@ -0,0 +1,104 @@
+#include <iomanip>
+#include <mutex>
+#include "searchstats.h"
+
+static std::mutex global_mutex;
+static SearchStats global_stats;
+
+void IterationStats::add(const IterationStats &s) {
+    nodes += s.nodes;
+    qnodes += s.qnodes;
+    cutoffs += s.cutoffs;
+    first_move_cutoffs += s.first_move_cutoffs;
+    tt_probes += s.tt_probes;
+    tt_hits += s.tt_hits;
+    tt_cutoffs += s.tt_cutoffs;
+    eval_cache_probes += s.eval_cache_probes;
+    eval_cache_hits += s.eval_cache_hits;
+    moves_generated += s.moves_generated;
+    moves_searched += s.moves_searched;
+    movegen_ns += s.movegen_ns;
+    eval_ns += s.eval_ns;
+}
+
+IterationStats &SearchStats::iteration(int depth) {
+    return iterations[depth < STATS_MAX_DEPTH ? depth : STATS_MAX_DEPTH];
+}
+
+void SearchStats::add(const SearchStats &s) {
+    for (int d = 0; d <= STATS_MAX_DEPTH; d++) {
+        iterations[d].add(s.iterations[d]);
+    }
+}
+
+SearchStats &threadSearchStats() {
+    static thread_local SearchStats stats;
+    return stats;
+}
+
+void mergeSearchStats() {
+    SearchStats &local = threadSearchStats();
+    std::lock_guard<std::mutex> lock(global_mutex);
+    global_stats.add(local);
+    local = SearchStats();
+}
+
+SearchStats globalSearchStats() {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    return global_stats;
+}
+
+void resetSearchStats() {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    global_stats = SearchStats();
+}
+
+// returns 100 * x / y, 0 if y == 0
+static double percent(uint64_t x, uint64_t y) {
+    return y == 0 ? 0 : 100.0 * x / y;
+}
+
+void printIterationStats(std::ostream &out, int depth, const IterationStats &s,
+                         uint64_t prev_nodes) {
+    out << "stats depth=" << depth << " nodes=" << s.nodes << " qnodes=" << s.qnodes
+        << std::fixed << std::setprecision(2)
+        << " ebf=" << (prev_nodes == 0 ? 0 : (double) (s.nodes + s.qnodes) / prev_nodes)
+        << " cutoffs=" << s.cutoffs << " first_move_cutoffs=" << s.first_move_cutoffs
+        << " tt_probes=" << s.tt_probes << " tt_hits=" << s.tt_hits
+        << " tt_cutoffs=" << s.tt_cutoffs
+        << " eval_cache_probes=" << s.eval_cache_probes
+        << " eval_cache_hits=" << s.eval_cache_hits
+        << " moves_generated=" << s.moves_generated
+        << " moves_searched=" << s.moves_searched
+        << " movegen_ms=" << s.movegen_ns / 1e6 << " eval_ms=" << s.eval_ns / 1e6
+        << std::defaultfloat << std::endl;
+}
+
+void printSearchStats(std::ostream &out) {
+    SearchStats stats = globalSearchStats();
+    out << "depth      nodes     qnodes   ebf  cut%  1st%   tt hit%  tt cut%"
+           "  ec hit%  searched%  movegen ms  eval ms" << std::endl;
+    uint64_t prev = 0;
+    for (int d = 0; d <= STATS_MAX_DEPTH; d++) {
+        const IterationStats &s = stats.iterations[d];
+        if (s.nodes + s.qnodes == 0) {
+            continue;
+        }
+        // the branching factor compares the total nodes of two consecutive
+        // depths
+        double ebf = prev == 0 ? 0 : (double) (s.nodes + s.qnodes) / prev;
+        out << std::setw(5) << d << std::setw(11) << s.nodes << std::setw(11) << s.qnodes
+            << std::fixed << std::setprecision(1)
+            << std::setw(6) << ebf
+            << std::setw(6) << percent(s.cutoffs, s.nodes)
+            << std::setw(6) << percent(s.first_move_cutoffs, s.cutoffs)
+            << std::setw(10) << percent(s.tt_hits, s.tt_probes)
+            << std::setw(9) << percent(s.tt_cutoffs, s.tt_probes)
+            << std::setw(9) << percent(s.eval_cache_hits, s.eval_cache_probes)
+            << std::setw(11) << percent(s.moves_searched, s.moves_generated)
+            << std::setw(12) << s.movegen_ns / 1e6
+            << std::setw(9) << s.eval_ns / 1e6
+            << std::defaultfloat << std::endl;
+        prev = s.nodes + s.qnodes;
+    }
+}
@@ -0,0 +1,87 @@
+// This module counts what the search does, to understand why a search takes
+// long: nodes, cutoffs, hits of the transposition table and of the
+// evaluation cache, moves generated and searched, time spent generating
+// moves and evaluating, for each depth of the iterative deepening (see
+// search.h).
+//
+// The counters only exist when the program is compiled with -DSEARCH_STATS
+// ("make STATS=1"). Otherwise SEARCH_STAT(x) expands to nothing, and the
+// search is exactly the same code as without this module.
+//
+// Each thread counts in its own thread_local SearchStats, so that several
+// searching threads don't share cache lines. Search::run() adds them to the
+// global statistics when it returns, which are printed by the "stats" command.
+
+#ifndef SEARCHSTATS_H_
+#define SEARCHSTATS_H_
+
+#include <cstdint>
+#include <ostream>
+
+#ifdef SEARCH_STATS
+#define SEARCH_STAT(x) x
+#else
+#define SEARCH_STAT(x)
+#endif
+
+// the iterations deeper than this are counted with the last one
+const int STATS_MAX_DEPTH = 32;
+
+// the counters of the iterations at one depth
+struct IterationStats {
+    // nodes of the alpha-beta search, and of the quiescence search
+    uint64_t nodes = 0;
+    uint64_t qnodes = 0;
+    // nodes of the alpha-beta search with a beta cutoff, and those where it
+    // was produced by the first move searched
+    uint64_t cutoffs = 0;
+    uint64_t first_move_cutoffs = 0;
+    // transposition table probes, the ones that found the position, and the
+    // ones that returned without searching
+    uint64_t tt_probes = 0;
+    uint64_t tt_hits = 0;
+    uint64_t tt_cutoffs = 0;
+    // evaluation cache probes, and the ones that found the position
+    uint64_t eval_cache_probes = 0;
+    uint64_t eval_cache_hits = 0;
+    // legal moves generated, and the ones actually searched
+    uint64_t moves_generated = 0;
+    uint64_t moves_searched = 0;
+    // time spent in the move generation and in the evaluation
+    uint64_t movegen_ns = 0;
+    uint64_t eval_ns = 0;
+
+    void add(const IterationStats &s);
+};
+
+struct SearchStats {
+    // iterations[d] counts the iterations of depth d
+    IterationStats iterations[STATS_MAX_DEPTH + 1];
+
+    IterationStats &iteration(int depth);
+
+    void add(const SearchStats &s);
+};
+
+// the statistics of the calling thread, not yet added to the global ones
+SearchStats &threadSearchStats();
+
+// adds the statistics of the calling thread to the global ones, and resets
+// them
+void mergeSearchStats();
+
+// returns a copy of the global statistics
+SearchStats globalSearchStats();
+
+void resetSearchStats();
+
+// prints one line of "key=value" counters for the iteration of depth depth.
+// prev is the number of nodes of the previous iteration, used for the
+// effective branching factor.
+void printIterationStats(std::ostream &out, int depth, const IterationStats &s,
+                         uint64_t prev_nodes);
+
+// prints a table of the global statistics, one line per depth
+void printSearchStats(std::ostream &out);
+
+#endif // SEARCHSTATS_H_
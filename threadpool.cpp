@@ -0,0 +1,252 @@
+#include <algorithm>
+#include "threadpool.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// the pool and index of the calling thread, if it is a worker
+static thread_local const ThreadPool *current_pool = NULL;
+static thread_local int current_worker = -1;
+
+WorkDeque::WorkDeque() : top_(0), bottom_(0) {
+    arrays_.emplace_back(new Array(64));
+    array_.store(arrays_.back().get());
+}
+
+WorkDeque::~WorkDeque() { }
+
+WorkDeque::Array *WorkDeque::grow(Array *a, int64_t bottom, int64_t top) {
+    Array *bigger = new Array(2 * a->size);
+    for (int64_t i = top; i < bottom; i++) {
+        bigger->put(i, a->get(i));
+    }
+    arrays_.emplace_back(bigger);
+    array_.store(bigger, std::memory_order_release);
+    return bigger;
+}
+
+void WorkDeque::push(Task *t) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    Array *a = array_.load(std::memory_order_relaxed);
+    if (b - top > a->size - 1) {
+        a = grow(a, b, top);
+    }
+    a->put(b, t);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+}
+
+Task *WorkDeque::pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Array *a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+        // empty
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return NULL;
+    }
+    Task *task = a->get(b);
+    if (t == b) {
+        // the last task: a thief may take it at the same time
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            task = NULL;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+Task *WorkDeque::steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+        return NULL;
+    }
+    Array *a = array_.load(std::memory_order_acquire);
+    Task *task = a->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+        return NULL;
+    }
+    return task;
+}
+
+ThreadPool::ThreadPool(int workers, bool pin) : queued_(0), sleeping_(0), stop_(false) {
+    if (workers <= 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < workers; i++) {
+        deques_.emplace_back(new WorkDeque());
+    }
+    for (int i = 0; i < workers; i++) {
+        threads_.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+#ifdef __linux__
+        if (pin) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+            pthread_setaffinity_np(threads_.back().native_handle(), sizeof(cpus), &cpus);
+        }
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+        wake_.notify_all();
+    }
+    for (auto &t : threads_) {
+        t.join();
+    }
+}
+
+int ThreadPool::size() const {
+    return deques_.size();
+}
+
+int ThreadPool::workerId() const {
+    return current_pool == this ? current_worker : -1;
+}
+
+void ThreadPool::submit(Task *t) {
+    int id = workerId();
+    if (id >= 0) {
+        deques_[id]->push(t);
+    } else {
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+        shared_.push_back(t);
+    }
+    queued_++;
+    if (sleeping_ > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        wake_.notify_one();
+    }
+}
+
+Task *ThreadPool::findTask(int id) {
+    if (queued_ == 0) {
+        return NULL;
+    }
+    Task *t = (id >= 0) ? deques_[id]->pop() : NULL;
+    // the deques of the other workers, starting after id
+    int n = size();
+    for (int k = 1; t == NULL && k <= n; k++) {
+        int victim = (id + k + n) % n;
+        if (victim != id) {
+            t = deques_[victim]->steal();
+        }
+    }
+    if (t == NULL) {
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+        if (!shared_.empty()) {
+            t = shared_.front();
+            shared_.pop_front();
+        }
+    }
+    if (t != NULL) {
+        queued_--;
+    }
+    return t;
+}
+
+bool ThreadPool::runOneTask() {
+    Task *t = findTask(workerId());
+    if (t == NULL) {
+        return false;
+    }
+    if (!t->group->isCancelled()) {
+        t->run();
+    }
+    t->group->done();
+    delete t;
+    return true;
+}
+
+void ThreadPool::workerLoop(int id) {
+    current_pool = this;
+    current_worker = id;
+    while (true) {
+        if (runOneTask()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleeping_++;
+        while (queued_ == 0 && !stop_) {
+            wake_.wait(lock);
+        }
+        sleeping_--;
+        if (stop_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool &pool) : pool_(pool), pending_(0), cancelled_(false) { }
+
+TaskGroup::~TaskGroup() {
+    wait();
+}
+
+void TaskGroup::run(std::function<void()> f) {
+    pending_++;
+    pool_.submit(new Task{std::move(f), this});
+}
+
+void TaskGroup::wait() {
+    if (pool_.workerId() >= 0) {
+        // a worker helps instead of blocking, the tasks it waits for may be
+        // in its own deque
+        while (pending_ > 0) {
+            if (!pool_.runOneTask()) {
+                std::this_thread::yield();
+            }
+        }
+        // the last done() may still hold the lock
+        std::lock_guard<std::mutex> lock(mutex_);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pending_ > 0) {
+        finished_.wait(lock);
+    }
+}
+
+void TaskGroup::cancel() {
+    cancelled_ = true;
+}
+
+bool TaskGroup::isCancelled() const {
+    return cancelled_;
+}
+
+void TaskGroup::done() {
+    // the lock keeps the group alive until the waiting thread is notified
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0) {
+        finished_.notify_all();
+    }
+}
+
+void parallelFor(ThreadPool &pool, size_t n,
+                 const std::function<void(size_t i, int worker)> &f, size_t grain) {
+    TaskGroup g(pool);
+    grain = std::max<size_t>(1, grain);
+    for (size_t first = 0; first < n; first += grain) {
+        size_t last = std::min(n, first + grain);
+        g.run([&pool, &f, first, last]() {
+            int worker = pool.workerId();
+            for (size_t i = first; i < last; i++) {
+                f(i, worker);
+            }
+        });
+    }
+    g.wait();
+}
@@ -0,0 +1,175 @@
+// This module implements a work-stealing thread pool, used by all the parallel
+// jobs of the program (replay and import of games, position index, perft,
+// batch analysis...) instead of threads created by each job.
+//
+// The pool has a fixed number of workers. Each one owns a Chase-Lev deque:
+// the tasks it creates are pushed and popped at the bottom of its own deque
+// without any lock, and a worker without tasks steals them at the top of the
+// deque of another one. The tasks submitted by other threads go through a
+// shared queue. Idle workers sleep until a task is submitted.
+// see "Dynamic Circular Work-Stealing Deque", Chase and Lev, 2005, and
+// "Correct and Efficient Work-Stealing for Weak Memory Models", Lê et al.,
+// 2013, for the memory orderings used here.
+//
+// The tasks are grouped in TaskGroups, which can be waited for or cancelled:
+//
+//   ThreadPool pool(4);
+//   TaskGroup g(pool);
+//   for (int i = 0; i < 100; i++) {
+//       g.run([i]() { ... });
+//   }
+//   g.wait();
+//
+// A worker that waits for a group runs the tasks of the pool meanwhile, so
+// tasks can create and wait for other tasks. A thread outside the pool just
+// blocks.
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+struct Task {
+    std::function<void()> run;
+    TaskGroup *group;
+};
+
+// The deque of a worker. push() and pop() are only called by its owner,
+// steal() by any thread.
+class WorkDeque {
+public:
+    WorkDeque();
+
+    ~WorkDeque();
+
+    void push(Task *t);
+
+    // returns the last task pushed, or NULL if the deque is empty
+    Task *pop();
+
+    // returns the oldest task, or NULL if the deque is empty or another
+    // thread took the task at the same time
+    Task *steal();
+
+private:
+    struct Array {
+        int64_t size;
+        std::unique_ptr<std::atomic<Task *>[]> tasks;
+
+        explicit Array(int64_t n) : size(n), tasks(new std::atomic<Task *>[n]) { }
+
+        Task *get(int64_t i) const {
+            return tasks[i & (size - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t i, Task *t) {
+            tasks[i & (size - 1)].store(t, std::memory_order_relaxed);
+        }
+    };
+
+    // replaces the array by one twice as large. The old one may still be read
+    // by a thief, it is only deleted with the deque.
+    Array *grow(Array *a, int64_t bottom, int64_t top);
+
+    std::atomic<int64_t> top_;
+    std::atomic<int64_t> bottom_;
+    std::atomic<Array *> array_;
+    std::vector<std::unique_ptr<Array> > arrays_;
+};
+
+class ThreadPool {
+public:
+    // starts workers threads, one per hardware thread if workers <= 0. If pin
+    // is true, worker i only runs on CPU i (modulo the number of CPUs), on
+    // the systems that support it.
+    explicit ThreadPool(int workers = 0, bool pin = false);
+
+    // waits for the tasks in progress and stops the workers
+    ~ThreadPool();
+
+    // number of workers
+    int size() const;
+
+    // returns the index of the calling thread among the workers of this pool,
+    // or -1 if it is not one of them
+    int workerId() const;
+
+    // runs one task if there is one available, returns false otherwise
+    bool runOneTask();
+
+private:
+    friend class TaskGroup;
+
+    void submit(Task *t);
+
+    Task *findTask(int id);
+
+    void workerLoop(int id);
+
+    std::vector<std::unique_ptr<WorkDeque> > deques_;
+    std::vector<std::thread> threads_;
+
+    // the tasks submitted from outside the pool
+    std::mutex shared_mutex_;
+    std::deque<Task *> shared_;
+
+    // tasks submitted and not started, and sleeping workers
+    std::atomic<long> queued_;
+    std::atomic<int> sleeping_;
+    std::atomic<bool> stop_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+};
+
+// A set of tasks run by a ThreadPool, that can be waited for together.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool &pool);
+
+    // waits for the tasks of the group
+    ~TaskGroup();
+
+    // submits f to the pool
+    void run(std::function<void()> f);
+
+    // returns when all the tasks of the group are finished or skipped
+    void wait();
+
+    // the tasks of the group that are not started yet will be skipped. The
+    // running tasks can check isCancelled() to stop early.
+    void cancel();
+
+    bool isCancelled() const;
+
+private:
+    friend class ThreadPool;
+
+    // called by the pool when a task of the group is finished
+    void done();
+
+    ThreadPool &pool_;
+    std::atomic<long> pending_;
+    std::atomic<bool> cancelled_;
+    std::mutex mutex_;
+    std::condition_variable finished_;
+};
+
+// calls f(i, worker) for i in 0..n-1 on the workers of pool, worker being
+// the index of the worker that runs the call (see ThreadPool::workerId()),
+// e.g. to use one Board per worker. The calls are grouped by grain
+// consecutive indices per task. Returns when all the calls are finished.
+void parallelFor(ThreadPool &pool, size_t n,
+                 const std::function<void(size_t i, int worker)> &f, size_t grain = 1);
+
+#endif // THREADPOOL_H_
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "trace.h"
+
+static thread_local TraceWriter *thread_trace = NULL;
+
+TraceWriter *threadTrace() {
+    return thread_trace;
+}
+
+void setThreadTrace(TraceWriter *trace) {
+    thread_trace = trace;
+}
+
+TraceNodeType traceNodeType(int alpha, int beta, int score) {
+    if (score >= beta) {
+        return NODE_CUT;
+    }
+    if (score <= alpha) {
+        return NODE_ALL;
+    }
+    return NODE_PV;
+}
+
+TraceWriter::TraceWriter() : head_(0), tail_(0), stop_(false) { }
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string &filename, size_t capacity) {
+    close();
+    file_ = std::fopen(filename.c_str(), "wb");
+    if (file_ == NULL) {
+        return false;
+    }
+    TraceHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+    h.version = TRACE_VERSION;
+    h.record_size = sizeof(TraceRecord);
+    std::fwrite(&h, sizeof(h), 1, file_);
+    size_t size = 4;
+    while (size < capacity) {
+        size *= 2;
+    }
+    buffer_.assign(size, TraceRecord());
+    mask_ = size - 1;
+    head_ = 0;
+    tail_ = 0;
+    stop_ = false;
+    writer_ = std::thread(&TraceWriter::writeLoop, this);
+    return true;
+}
+
+void TraceWriter::close() {
+    if (file_ == NULL) {
+        return;
+    }
+    stop_ = true;
+    wakeWriter();
+    writer_.join();
+    flush();
+    std::fclose(file_);
+    file_ = NULL;
+    buffer_.clear();
+}
+
+bool TraceWriter::isOpen() const {
+    return file_ != NULL;
+}
+
+uint64_t TraceWriter::size() const {
+    return head_.load();
+}
+
+void TraceWriter::wakeWriter() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_.notify_one();
+}
+
+void TraceWriter::writeLoop() {
+    while (!stop_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        flush();
+    }
+}
+
+bool TraceWriter::flush() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    bool ok = true;
+    while (tail < head) {
+        // the records up to the end of the buffer, then from its beginning
+        uint64_t first = tail & mask_;
+        uint64_t count = std::min(head - tail, mask_ + 1 - first);
+        ok = std::fwrite(&buffer_[first], sizeof(TraceRecord), count, file_) == count && ok;
+        tail += count;
+        tail_.store(tail, std::memory_order_release);
+    }
+    return ok;
+}
@@ -0,0 +1,143 @@
+// This module records the tree explored by the search in a binary file, to
+// find offline which subtrees used the nodes (see traceanalyze.cpp).
+//
+// The recording is compiled in with -DSEARCH_TRACE ("make TRACE=1"), otherwise
+// SEARCH_TRACE_DO(...) expands to nothing and the search is unchanged. It is
+// then started by setThreadTrace(): the searches run by the calling thread
+// write one TraceRecord per node when they leave it, so the file lists the
+// nodes in post-order, each one after its subtree.
+//
+// The search thread only copies the record in a ring buffer allocated once;
+// a background thread writes the buffer to the file. If the buffer is full,
+// the search waits for the writer, no record is lost.
+//
+// The file is a TraceHeader followed by the records.
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef SEARCH_TRACE
+#define SEARCH_TRACE_DO(...) __VA_ARGS__
+#else
+#define SEARCH_TRACE_DO(...)
+#endif
+
+const char TRACE_MAGIC[4] = {'C', 'T', 'R', 'C'};
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+};
+
+enum TraceNodeType { NODE_PV = 0, NODE_CUT = 1, NODE_ALL = 2 };
+
+// set in TraceRecord::type for the nodes of the quiescence search
+const uint8_t NODE_QUIESCENCE = 4;
+
+// the code of the move that leads to the root of a search
+const uint16_t NO_MOVE = 0xFFFF;
+
+// the cutoff_index of a node without beta cutoff
+const uint8_t NO_CUTOFF = 0xFF;
+
+struct TraceRecord {
+    // nodes of the subtree, this one included
+    uint32_t subtree_nodes;
+    // the window the node was searched with, and its score
+    int32_t alpha;
+    int32_t beta;
+    int32_t score;
+    // the move that leads to the node (see encodeMove()), NO_MOVE for a root
+    uint16_t move;
+    // the depth of the iterative deepening iteration
+    uint16_t iteration;
+    // distance to the root, and depth left (0 in the quiescence search)
+    uint8_t ply;
+    uint8_t depth;
+    // a TraceNodeType, ored with NODE_QUIESCENCE
+    uint8_t type;
+    // the index of the move that produced the beta cutoff, or NO_CUTOFF
+    uint8_t cutoff_index;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must be 24 bytes");
+
+// returns the TraceNodeType of a node whose score is score in the window
+// [alpha, beta]
+TraceNodeType traceNodeType(int alpha, int beta, int score);
+
+// A trace file being written. record() is called by one thread only.
+class TraceWriter {
+public:
+    TraceWriter();
+
+    ~TraceWriter();
+
+    // creates the file filename and starts the writing thread, with a ring
+    // buffer of capacity records (rounded up to a power of 2).
+    // returns false if the file can't be created.
+    bool open(const std::string &filename, size_t capacity = 1 << 20);
+
+    // writes the records left and closes the file
+    void close();
+
+    bool isOpen() const;
+
+    // number of records written or buffered
+    uint64_t size() const;
+
+    void record(const TraceRecord &r) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        while (head - tail_.load(std::memory_order_acquire) > mask_) {
+            wakeWriter();
+            std::this_thread::yield();
+        }
+        buffer_[head & mask_] = r;
+        head_.store(head + 1, std::memory_order_release);
+        if (((head + 1) & ((mask_ + 1) / 4 - 1)) == 0) {
+            // a quarter of the buffer was filled
+            wakeWriter();
+        }
+    }
+
+private:
+    void wakeWriter();
+
+    void writeLoop();
+
+    // writes the records in [tail_, head_)
+    bool flush();
+
+    std::FILE *file_ = NULL;
+    std::vector<TraceRecord> buffer_;
+    uint64_t mask_ = 0;
+    // head_ is written by the search thread, tail_ by the writing thread
+    std::atomic<uint64_t> head_;
+    std::atomic<uint64_t> tail_;
+    std::atomic<bool> stop_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread writer_;
+};
+
+// the trace of the searches of the calling thread, NULL if they are not
+// traced
+TraceWriter *threadTrace();
+
+// traces the searches of the calling thread in trace, or stops tracing if
+// trace is NULL. The TraceWriter is not owned.
+void setThreadTrace(TraceWriter *trace);
+
+#endif // TRACE_H_
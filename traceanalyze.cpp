@@ -0,0 +1,178 @@
+// This program summarizes a trace of the search written with "make TRACE=1"
+// (see trace.h):
+//
+//   traceanalyze file.trc [top] [max_ply]
+//
+// It prints, for each ply, the number of nodes of each type and the index of
+// the move that produced the beta cutoffs, then the most expensive
+// subtrees (10 by default) rooted at plies 1 to max_ply (2 by default), with
+// the iteration they belong to (numbered in the order of the file) and the
+// moves that lead to them.
+//
+// The records are in post-order, so reading the file backwards visits each
+// node before its subtree: the parent of a node is the last node read at the
+// ply above.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "trace.h"
+
+static const char PROMOTIONS[] = "qrbn";
+
+// returns the coordinates of move code (see encodeMove()), e.g. "e2e4"
+static std::string moveName(uint16_t code) {
+    if (code == NO_MOVE) {
+        return "root";
+    }
+    std::string s;
+    for (int sq : {code & 63, (code >> 6) & 63}) {
+        s += (char) ('a' + sq % 8);
+        s += (char) ('1' + sq / 8);
+    }
+    if (code >> 12) {
+        s += PROMOTIONS[code >> 12];
+    }
+    return s;
+}
+
+static const char *typeName(uint8_t type) {
+    static const char *names[] = {"pv", "cut", "all"};
+    return names[type & 3];
+}
+
+static bool readTrace(const char *filename, std::vector<TraceRecord> &records) {
+    std::FILE *file = std::fopen(filename, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    TraceHeader h;
+    bool ok = std::fread(&h, sizeof(h), 1, file) == 1 &&
+              memcmp(h.magic, TRACE_MAGIC, sizeof(h.magic)) == 0 &&
+              h.version == TRACE_VERSION && h.record_size == sizeof(TraceRecord);
+    TraceRecord r;
+    while (ok && std::fread(&r, sizeof(r), 1, file) == 1) {
+        records.push_back(r);
+    }
+    std::fclose(file);
+    return ok;
+}
+
+struct PlyStats {
+    uint64_t nodes = 0;
+    uint64_t qnodes = 0;
+    uint64_t types[3] = {0, 0, 0};
+    // beta cutoffs by the move of index 0, 1, 2-3, 4 and more
+    uint64_t cutoffs[4] = {0, 0, 0, 0};
+    uint64_t subtree_nodes = 0;
+};
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cout << "usage: traceanalyze file.trc [top] [max_ply]" << std::endl;
+        return 1;
+    }
+    size_t top = (argc >= 3) ? std::stoul(argv[2]) : 10;
+    int max_ply = (argc >= 4) ? std::stoi(argv[3]) : 2;
+    std::vector<TraceRecord> records;
+    if (!readTrace(argv[1], records)) {
+        std::cout << "Impossible to read the trace" << std::endl;
+        return 1;
+    }
+
+    // parent[i] is the index of the parent of records[i], root[i] the index
+    // of the root of its search
+    std::vector<uint32_t> parent(records.size());
+    std::vector<uint32_t> root(records.size());
+    std::vector<uint32_t> last_at_ply;
+    std::vector<PlyStats> plies;
+    size_t searches = 0;
+    for (size_t i = records.size(); i-- > 0;) {
+        const TraceRecord &r = records[i];
+        if (r.ply >= last_at_ply.size()) {
+            last_at_ply.resize(r.ply + 1);
+            plies.resize(r.ply + 1);
+        }
+        last_at_ply[r.ply] = i;
+        parent[i] = (r.ply == 0) ? i : last_at_ply[r.ply - 1];
+        root[i] = (r.ply == 0) ? i : root[parent[i]];
+        searches += (r.ply == 0);
+
+        PlyStats &st = plies[r.ply];
+        if (r.type & NODE_QUIESCENCE) {
+            st.qnodes++;
+        } else {
+            st.nodes++;
+        }
+        st.types[r.type & 3]++;
+        st.subtree_nodes += r.subtree_nodes;
+        if (r.cutoff_index != NO_CUTOFF) {
+            int bucket = r.cutoff_index < 2 ? r.cutoff_index : r.cutoff_index < 4 ? 2 : 3;
+            st.cutoffs[bucket]++;
+        }
+    }
+    std::cout << records.size() << " nodes, " << searches << " iterations searched"
+              << std::endl << std::endl;
+
+    std::cout << "ply      nodes     qnodes        pv       cut       all"
+                 "   cut@0   cut@1  cut@2-3  cut@4+  avg subtree" << std::endl;
+    for (size_t p = 0; p < plies.size(); p++) {
+        const PlyStats &st = plies[p];
+        uint64_t total = st.nodes + st.qnodes;
+        uint64_t cutoffs = st.cutoffs[0] + st.cutoffs[1] + st.cutoffs[2] + st.cutoffs[3];
+        std::cout << std::setw(3) << p << std::setw(11) << st.nodes << std::setw(11) << st.qnodes
+                  << std::setw(10) << st.types[NODE_PV] << std::setw(10) << st.types[NODE_CUT]
+                  << std::setw(10) << st.types[NODE_ALL] << std::fixed << std::setprecision(1);
+        for (int k = 0; k < 4; k++) {
+            std::cout << std::setw(k == 2 ? 8 : 7)
+                      << (cutoffs == 0 ? 0 : 100.0 * st.cutoffs[k] / cutoffs) << "%";
+        }
+        std::cout << std::setw(13) << (total == 0 ? 0 : (double) st.subtree_nodes / total)
+                  << std::defaultfloat << std::endl;
+    }
+
+    // the searched iterations are numbered from 1 in the order of the file
+    std::vector<uint32_t> root_number(records.size());
+    uint32_t n = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].ply == 0) {
+            root_number[i] = ++n;
+        }
+    }
+
+    std::vector<uint32_t> candidates;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].ply >= 1 && records[i].ply <= max_ply) {
+            candidates.push_back(i);
+        }
+    }
+    top = std::min(top, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + top, candidates.end(),
+                      [&records](uint32_t x, uint32_t y) {
+        return records[x].subtree_nodes > records[y].subtree_nodes;
+    });
+    std::cout << std::endl << "most expensive subtrees:" << std::endl;
+    std::cout << "    nodes  % of search  search  iteration  type    score  moves" << std::endl;
+    for (size_t k = 0; k < top; k++) {
+        uint32_t i = candidates[k];
+        const TraceRecord &r = records[i];
+        std::vector<std::string> path;
+        for (uint32_t j = i; records[j].ply > 0; j = parent[j]) {
+            path.push_back(moveName(records[j].move));
+        }
+        std::cout << std::setw(9) << r.subtree_nodes << std::fixed << std::setprecision(1)
+                  << std::setw(12) << 100.0 * r.subtree_nodes / records[root[i]].subtree_nodes
+                  << "%" << std::defaultfloat << std::setw(8) << root_number[root[i]]
+                  << std::setw(11) << r.iteration << std::setw(6) << typeName(r.type)
+                  << std::setw(9) << r.score << " ";
+        for (size_t m = path.size(); m-- > 0;) {
+            std::cout << " " << path[m];
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
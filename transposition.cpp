@@ -0,0 +1,92 @@
+#include "transposition.h"
+#include "search.h"
+
+// the scores beyond this are mates
+static const int MATE_BOUND = MATE - 1000;
+
+TranspositionTable::TranspositionTable(size_t size_mb) {
+    size_t n = 1;
+    while (2 * n * 2 * sizeof(TTEntry) <= size_mb * 1024 * 1024) {
+        n *= 2;
+    }
+    entries_.resize(2 * n);
+    mask_ = n - 1;
+    clear();
+}
+
+const TTEntry *TranspositionTable::probe(uint64_t key) const {
+    const TTEntry *bucket = &entries_[2 * (key & mask_)];
+    for (int k = 0; k < 2; k++) {
+        if (bucket[k].key == key && bucket[k].flags != 0xFF) {
+            return &bucket[k];
+        }
+    }
+    return NULL;
+}
+
+void TranspositionTable::store(uint64_t key, int score, uint16_t move, int depth, TTBound bound) {
+    TTEntry *bucket = &entries_[2 * (key & mask_)];
+    TTEntry &deep = bucket[0];
+    TTEntry &latest = bucket[1];
+    bool in_deep = deep.flags != 0xFF && deep.key == key;
+    bool in_latest = latest.flags != 0xFF && latest.key == key;
+    if (move == TT_NO_MOVE) {
+        // keep the best move found by a previous search of the position
+        move = in_deep ? deep.move : in_latest ? latest.move : move;
+    }
+    TTEntry *e;
+    if (deep.flags == 0xFF || (deep.flags >> 2) != generation_ || depth >= deep.depth) {
+        e = &deep;
+        if (in_latest) {
+            // the position is not stored twice
+            latest.flags = 0xFF;
+        }
+    } else if (in_deep) {
+        // a deeper result of the same search is kept
+        return;
+    } else {
+        e = &latest;
+    }
+    e->key = key;
+    e->score = score;
+    e->move = move;
+    e->depth = depth;
+    e->flags = bound | (generation_ << 2);
+}
+
+void TranspositionTable::newSearch() {
+    // the generation 0x3F is left to the flags of the empty entries
+    generation_ = (generation_ + 1) % 0x3F;
+}
+
+void TranspositionTable::clear() {
+    for (auto &e : entries_) {
+        e = TTEntry();
+        e.flags = 0xFF;
+    }
+    generation_ = 0;
+}
+
+size_t TranspositionTable::size() const {
+    return entries_.size();
+}
+
+int scoreToTT(int score, int ply) {
+    if (score > MATE_BOUND) {
+        return score + ply;
+    }
+    if (score < -MATE_BOUND) {
+        return score - ply;
+    }
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score > MATE_BOUND) {
+        return score - ply;
+    }
+    if (score < -MATE_BOUND) {
+        return score + ply;
+    }
+    return score;
+}
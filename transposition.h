@@ -0,0 +1,83 @@
+// This module implements the transposition table of the search: a hash table,
+// indexed by the Zobrist key of the positions (see Board::hash()), that
+// remembers the result of the positions already searched. A position reached
+// again, by another order of moves or in a later search, is then searched
+// first with the best move found before, or not searched at all if the
+// stored result is deep enough.
+// see https://www.chessprogramming.org/Transposition_Table
+//
+// The table has a fixed size, made of buckets of two entries. A position goes
+// to the first entry of its bucket if the one there is from an older search
+// or was searched less deeply, and otherwise to the second entry, which is
+// always replaced: the deep results are kept, and the latest one is found
+// too. A table is used by one Search at a time, and can be kept from one
+// search to the next.
+
+#ifndef TRANSPOSITION_H_
+#define TRANSPOSITION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// the kind of score stored: exact, or a bound of the real score when the
+// search failed high (LOWER) or low (UPPER)
+enum TTBound { TT_EXACT = 0, TT_LOWER = 1, TT_UPPER = 2 };
+
+// the move of an entry without best move (a1a1 is never legal)
+const uint16_t TT_NO_MOVE = 0;
+
+struct TTEntry {
+    uint64_t key;
+    // the score, mates counted from the position (see scoreToTT())
+    int32_t score;
+    // the best move, see encodeMove(), or TT_NO_MOVE
+    uint16_t move;
+    int8_t depth;
+    // the TTBound in the 2 low bits, the generation of the search above
+    uint8_t flags;
+
+    TTBound bound() const {
+        return (TTBound) (flags & 3);
+    }
+};
+
+static_assert(sizeof(TTEntry) == 16, "TTEntry must be 16 bytes");
+
+class TranspositionTable {
+public:
+    // allocates about size_mb megabytes (rounded down to a power of 2
+    // buckets)
+    explicit TranspositionTable(size_t size_mb = 16);
+
+    // returns the entry of the position key, or NULL if it is not stored
+    const TTEntry *probe(uint64_t key) const;
+
+    void store(uint64_t key, int score, uint16_t move, int depth, TTBound bound);
+
+    // called at the start of each search: the entries of the previous ones
+    // are replaced first
+    void newSearch();
+
+    // forgets all the positions
+    void clear();
+
+    // number of entries
+    size_t size() const;
+
+private:
+    // the buckets, entries 2*i and 2*i + 1
+    std::vector<TTEntry> entries_;
+    // the number of buckets - 1
+    size_t mask_;
+    uint8_t generation_ = 0;
+};
+
+// the score of a mate is stored as the distance from the position, and read
+// as the distance from the root of the search, ply being the distance between
+// the root and the position
+int scoreToTT(int score, int ply);
+
+int scoreFromTT(int score, int ply);
+
+#endif // TRANSPOSITION_H_
@@ -24,7 +24,7 @@
 #include "tree.h"
 #include "move.h"
 
-Tree::Tree() { }
+Tree::Tree(Arena &arena) : children_(&arena), arena_(arena) { }
 
 
 // add the opening given in `opening` vector starting from index i
@@ -36,7 +36,7 @@ void Tree::addOpening(const std::vector<Move *> &opening, int i) {
     Move *move = opening[i];
     Tree *t = NULL;
     if (children_.find(move) == children_.end()) {
-        t = new Tree();
+        t = arena_.make<Tree>(arena_);
         children_[move] = t;
     } else {
         t = children_[move];
@@ -73,7 +73,8 @@ void Tree::print_vector() {
 }
 /*
 int main() {
-    Tree *t = new Tree();
+    Arena arena;
+    Tree *t = arena.make<Tree>(arena);
 
     // add all the openings to the initially empty tree
     t->addOpening({"a", "f"}, 0);
@@ -5,12 +5,17 @@
 #include <map>
 
 #include "move.h"
+#include "arena.h"
 // This class defines a tree as seen by the 'main' module.
+//
+// The nodes of a tree and their maps are allocated in an Arena, and freed
+// with it (see Game::newOpenings()).
 
 
 class Tree {
 public:
-    Tree();
+    // an empty tree, whose nodes are allocated in arena
+    explicit Tree(Arena &arena);
 
     void addOpening(const std::vector<Move *> &opening, int i);
 
@@ -22,7 +27,8 @@ public:
 
 private:
     // a tree is a map from string (ie. move) to trees
-    std::map<Move *, Tree *> children_;
+    std::pmr::map<Move *, Tree *> children_;
+    Arena &arena_;
 
 };
 
@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "uci.h"
+#include "board.h"
+#include "notation.h"
+#include "pgn.h"
+#include "posindex.h"
+#include "replay.h"
+#include "search.h"
+#include "transposition.h"
+
+// the time left on the clock for the interface to receive the move, in ms
+static const long MOVE_OVERHEAD_MS = 50;
+
+// the number of moves the time left is shared among, when the interface
+// doesn't send movestogo
+static const int DEFAULT_MOVES_TO_GO = 30;
+
+// the arguments of a "go" command, 0 when not given
+struct GoParams {
+    long wtime = 0;
+    long btime = 0;
+    long winc = 0;
+    long binc = 0;
+    int movestogo = 0;
+    long movetime = 0;
+    int depth = 0;
+    long nodes = 0;
+    bool infinite = false;
+    bool ponder = false;
+};
+
+static GoParams parseGo(std::istringstream &args) {
+    GoParams p;
+    std::string name;
+    while (args >> name) {
+        if (name == "infinite" || name == "ponder") {
+            p.infinite = p.infinite || name == "infinite";
+            p.ponder = p.ponder || name == "ponder";
+            continue;
+        }
+        long value = 0;
+        args >> value;
+        if (name == "wtime") {
+            p.wtime = value;
+        } else if (name == "btime") {
+            p.btime = value;
+        } else if (name == "winc") {
+            p.winc = value;
+        } else if (name == "binc") {
+            p.binc = value;
+        } else if (name == "movestogo") {
+            p.movestogo = value;
+        } else if (name == "movetime") {
+            p.movetime = value;
+        } else if (name == "depth") {
+            p.depth = value;
+        } else if (name == "nodes") {
+            p.nodes = value;
+        }
+    }
+    return p;
+}
+
+// sets the time limits of a search by player: *hard_ms, when the search is
+// stopped, and *soft_ms, after which no iteration is started (0 for none).
+// With a clock, the move gets its share of the time left, plus 3/4 of the
+// increment.
+static void allocateTime(const GoParams &p, Color player, long *hard_ms, long *soft_ms) {
+    *hard_ms = 0;
+    *soft_ms = 0;
+    long time = (player == WHITE) ? p.wtime : p.btime;
+    long inc = (player == WHITE) ? p.winc : p.binc;
+    if (p.movetime > 0) {
+        *hard_ms = std::max(1L, p.movetime - MOVE_OVERHEAD_MS);
+    } else if (time > 0) {
+        int moves = (p.movestogo > 0) ? p.movestogo : DEFAULT_MOVES_TO_GO;
+        long target = time / moves + inc * 3 / 4;
+        *hard_ms = std::max(1L, std::min(target, time - MOVE_OVERHEAD_MS));
+        *soft_ms = *hard_ms / 2;
+    }
+}
+
+// the score of the info lines: in centipawns, or in moves to mate (negative
+// when the player to move is mated)
+static std::string scoreText(int score) {
+    if (std::abs(score) > MATE - 1000) {
+        int moves = (MATE - std::abs(score) + 1) / 2;
+        return "mate " + std::to_string(score > 0 ? moves : -moves);
+    }
+    return "cp " + std::to_string(score * 100 / PAWN_SCORE);
+}
+
+// the LAN of m, promotions being to a queen as in the search
+static std::string lan(const Move *m) {
+    return toLAN(m, m->isPromotion() ? 'Q' : ' ');
+}
+
+class UciEngine {
+public:
+    explicit UciEngine(std::ostream &out);
+
+    ~UciEngine();
+
+    // executes the command line, returns false if it is "quit"
+    bool execute(const std::string &line);
+
+private:
+    // writes line on out_, from any thread
+    void send(const std::string &line);
+
+    void position(std::istringstream &args);
+
+    void go(std::istringstream &args);
+
+    // the opponent played the expected move: the search on its time goes on
+    // as a normal search, with the time limits of the "go ponder" command
+    void ponderhit();
+
+    // stops the search, if any, and waits for its bestmove
+    void stop();
+
+    // the search thread: searches board_ with the given limits and writes
+    // the best move
+    void think(int depth, long nodes, long hard_ms, bool infinite);
+
+    // writes the info line of the iteration r
+    void info(const SearchResult &r);
+
+    // returns the LAN of the reply expected to the best move of r, the one
+    // to ponder on: the second move of the PV, or else the best move stored
+    // in the transposition table for the position after the best move. ""
+    // if there is none.
+    std::string expectedReply(const SearchResult &r);
+
+    std::ostream &out_;
+    std::mutex out_mutex_;
+    Board board_;
+    Search search_;
+    std::unique_ptr<TranspositionTable> tt_;
+    std::thread thread_;
+    // set by "stop", and by the search thread when the soft time limit is
+    // reached, see allocateTime()
+    std::atomic<bool> stop_;
+    // notified when stop_ is set by "stop" or pondering_ is reset by
+    // "ponderhit", see think()
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    // true while searching on the opponent's time ("go ponder")
+    bool pondering_ = false;
+    // the arguments of the last "go", and the player to move then, for the
+    // time limits of "ponderhit" (board_ belongs to the search thread)
+    GoParams go_;
+    Color player_ = WHITE;
+    std::chrono::steady_clock::time_point start_;
+    // the time since start_ after which no iteration is started, 0 for none
+    std::atomic<long> soft_ms_;
+};
+
+UciEngine::UciEngine(std::ostream &out) : out_(out), tt_(new TranspositionTable(UCI_HASH_MB)),
+                                          stop_(false), soft_ms_(0) {
+    search_.setTable(tt_.get());
+    search_.setStop(&stop_);
+    search_.setIterationVisitor([this](const SearchResult &r) { info(r); });
+}
+
+UciEngine::~UciEngine() {
+    stop();
+}
+
+void UciEngine::send(const std::string &line) {
+    std::lock_guard<std::mutex> lock(out_mutex_);
+    out_ << line << std::endl;
+}
+
+bool UciEngine::execute(const std::string &line) {
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+    if (command == "uci") {
+        send("id name cpp_project");
+        send("id author cpp_project");
+        send("option name Hash type spin default " + std::to_string(UCI_HASH_MB) +
+             " min 1 max 4096");
+        send("option name EvalCache type spin default " + std::to_string(EVAL_CACHE_KB) +
+             " min 0 max 65536");
+        // the interface decides when to ponder, the option only tells it can
+        send("option name Ponder type check default false");
+        send("uciok");
+    } else if (command == "isready") {
+        send("readyok");
+    } else if (command == "setoption") {
+        std::string word, name, value;
+        args >> word >> name >> word >> value;
+        if (name == "Hash" && std::atol(value.c_str()) > 0) {
+            stop();
+            tt_.reset(new TranspositionTable(std::atol(value.c_str())));
+            search_.setTable(tt_.get());
+        } else if (name == "EvalCache" && std::atol(value.c_str()) >= 0) {
+            stop();
+            search_.setEvalCacheSize(std::atol(value.c_str()));
+        }
+    } else if (command == "ucinewgame") {
+        stop();
+        tt_->clear();
+    } else if (command == "position") {
+        stop();
+        position(args);
+    } else if (command == "go") {
+        stop();
+        go(args);
+    } else if (command == "ponderhit") {
+        ponderhit();
+    } else if (command == "stop") {
+        stop();
+    } else if (command == "quit") {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void UciEngine::position(std::istringstream &args) {
+    PgnGame g;
+    std::string word;
+    args >> word;
+    if (word == "fen") {
+        std::string fen;
+        while (args >> word && word != "moves") {
+            fen += (fen.empty() ? "" : " ") + word;
+        }
+        g.tags.push_back(std::make_pair(std::string("FEN"), fen));
+    } else {
+        args >> word;
+    }
+    while (args >> word) {
+        g.moves.push_back(word);
+    }
+    ReplayResult res;
+    if (!replayGame(board_, g, res, MoveVisitor())) {
+        send("info string invalid position: " + res.error);
+    }
+}
+
+void UciEngine::go(std::istringstream &args) {
+    go_ = parseGo(args);
+    player_ = board_.getPlayer();
+    long hard_ms = 0;
+    long soft_ms = 0;
+    if (!go_.ponder) {
+        allocateTime(go_, player_, &hard_ms, &soft_ms);
+    }
+    soft_ms_ = soft_ms;
+    int depth = (go_.depth > 0) ? go_.depth : MAX_SEARCH_DEPTH;
+    start_ = std::chrono::steady_clock::now();
+    stop_ = false;
+    pondering_ = go_.ponder;
+    // a limit set by a "ponderhit" after the end of the previous search
+    search_.setTimeLimit(0);
+    thread_ = std::thread(&UciEngine::think, this, depth, go_.nodes, hard_ms, go_.infinite);
+}
+
+void UciEngine::ponderhit() {
+    long hard_ms;
+    long soft_ms;
+    allocateTime(go_, player_, &hard_ms, &soft_ms);
+    // the clock of the engine starts now, the iterations done so far are a
+    // gain
+    if (hard_ms > 0) {
+        search_.setTimeLimit(hard_ms);
+    }
+    if (soft_ms > 0) {
+        long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+        soft_ms_ = elapsed + soft_ms;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        pondering_ = false;
+    }
+    stop_cv_.notify_all();
+}
+
+void UciEngine::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stop_ = true;
+    }
+    stop_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void UciEngine::think(int depth, long nodes, long hard_ms, bool infinite) {
+    SearchResult r = search_.run(board_, depth, nodes, hard_ms);
+    {
+        // the best move of an infinite search is only sent after "stop", and
+        // the one of a search on the opponent's time after "ponderhit" too
+        std::unique_lock<std::mutex> lock(stop_mutex_);
+        stop_cv_.wait(lock, [this, infinite]() {
+            return stop_.load() || (!infinite && !pondering_);
+        });
+    }
+    if (r.best == NULL) {
+        send("bestmove 0000");
+    } else {
+        std::string reply = expectedReply(r);
+        send("bestmove " + lan(r.best) + (reply.empty() ? "" : " ponder " + reply));
+    }
+    deletePV(r, NULL);
+}
+
+void UciEngine::info(const SearchResult &r) {
+    long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+    std::ostringstream line;
+    line << "info depth " << r.depth << " score " << scoreText(r.score)
+         << " nodes " << r.nodes << " nps " << r.nodes * 1000 / std::max(1L, ms)
+         << " time " << ms << " pv";
+    // the PV stops at the first promotion: the moves after it refer to the
+    // piece created by the search, deleted since
+    for (auto m : r.pv) {
+        line << " " << lan(m);
+        if (m->isPromotion()) {
+            break;
+        }
+    }
+    send(line.str());
+    if (soft_ms_ > 0 && ms >= soft_ms_) {
+        stop_ = true;
+    }
+}
+
+std::string UciEngine::expectedReply(const SearchResult &r) {
+    if (r.pv.size() >= 2) {
+        return lan(r.pv[1]);
+    }
+    Move *best = r.best;
+    bool promotes = best->isPromotion();
+    best->perform(&board_);
+    board_.switch_player();
+    if (promotes) {
+        board_.promote_pawn_b(best, "Q");
+    }
+    std::string reply;
+    const TTEntry *e = tt_->probe(board_.hash());
+    if (e != NULL && e->move != TT_NO_MOVE) {
+        for (auto m : board_.getAllLegalMoves()) {
+            if (encodeMove(m, m->isPromotion() ? 'Q' : ' ') == e->move) {
+                reply = lan(m);
+            }
+            delete m;
+        }
+    }
+    if (promotes) {
+        board_.unpromote_pawn_b(best);
+    }
+    board_.switch_player();
+    best->unPerform(&board_);
+    return reply;
+}
+
+int runUci(std::istream &in, std::ostream &out) {
+    UciEngine engine(out);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!engine.execute(line)) {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+// This module implements the Universal Chess Interface (UCI), the protocol
+// with which graphical interfaces and match managers drive an engine:
+//
+//   main --uci
+//
+// see https://www.wbec-ridderkerk.nl/html/UCIProtocol.html
+//
+// The commands are read on the main thread and the search runs on a thread
+// of its own, so that "isready" and "stop" are answered at once, even in the
+// middle of a search. The commands understood are:
+//   uci, isready, ucinewgame, quit
+//   setoption name Hash value <mb>    the size of the transposition table
+//   setoption name EvalCache value <kb>    the size of the evaluation cache,
+//                                          0 for none
+//   position startpos|fen <fen> [moves <move>...]
+//   go [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>]
+//      [movetime <ms>] [depth <n>] [nodes <n>] [infinite] [ponder]
+//   ponderhit, stop
+// the moves being in LAN (e.g. e2e4, e1g1, e7e8q, see toLAN()).
+//
+// During a search, an "info" line is written after each iteration of the
+// iterative deepening (see search.h) with its depth, score, nodes, speed and
+// principal variation, and "bestmove" at the end. With a clock (wtime...),
+// the search gets a share of the time left plus most of the increment (see
+// allocateTime() in uci.cpp), and doesn't start an iteration after half of
+// it, since that iteration would likely not complete.
+//
+// Pondering: "bestmove" also gives the reply the engine expects, and the
+// interface may then send the position after that reply with "go ponder":
+// the engine searches it on the opponent's time, without time limit. If the
+// opponent plays the expected move, "ponderhit" turns it into a normal search
+// whose clock starts then: the iterations done meanwhile, and the
+// transposition table they filled, are a gain. Otherwise "stop" ends it and
+// the actual position is searched, with the table filled meanwhile.
+
+#ifndef UCI_H_
+#define UCI_H_
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+// the size of the transposition table until set by the Hash option, in
+// megabytes
+const size_t UCI_HASH_MB = 16;
+
+// reads UCI commands from in and answers on out until "quit" or the end of
+// in. Returns the exit code of the program.
+int runUci(std::istream &in, std::ostream &out);
+
+#endif // UCI_H_